@@ -0,0 +1,154 @@
+/*============================================================================
+| (c) Copyright IA UPM - Group 5, 2020.  All rights reserved.
+| Chromosome Sharing Test Program
+|
+| Copies chroms so they share genes, then frees, resizes and writes them in
+| the orders that have gone wrong before.  Exits 0 if every check passes;
+| build with -fsanitize=address to catch double frees and leaks too.
+============================================================================*/
+#include <stdio.h>
+#include <string.h>
+
+#include "ga.h"
+
+/* Number of failed checks */
+int failed = 0;
+
+/* Function prototypes */
+int obj_fun(Chrom_Ptr);
+int check(int, char *);
+int fill(Chrom_Ptr, int);
+int genes_are(Chrom_Ptr, int);
+
+/* Library functions ga.h does not declare */
+int CH_copy(), CH_free(), CH_resize();
+
+/*----------------------------------------------------------------------------
+| main()
+----------------------------------------------------------------------------*/
+int main()
+{
+  Chrom_Ptr a, b, c;
+  CH_Slab_Ptr slab;
+
+  /*--- Copy, free the source, resize the copy (sole holder of a share) ---*/
+  a = CH_alloc(10);
+  b = CH_alloc(10);
+  fill(a, 1);
+  CH_copy(a, b);
+  CH_free(a);
+  CH_resize(b, 5000);
+  check(b->length == 5000 && genes_are(b, 0), "resize of a sole holder");
+  CH_free(b);
+
+  /*--- Same, with packed genes ---*/
+  a = CH_alloc_type(100, DT_PACKED_BIT);
+  b = CH_alloc_type(100, DT_PACKED_BIT);
+  CH_copy(a, b);
+  CH_free(a);
+  CH_resize(b, 3000);
+  check(b->length == 3000 && CH_packed(b), "resize of a packed sole holder");
+  CH_free(b);
+
+  /*--- Resize while the genes are still shared ---*/
+  a = CH_alloc(10);
+  b = CH_alloc(10);
+  fill(a, 1);
+  CH_copy(a, b);
+  CH_resize(b, 20);
+  check(genes_are(a, 1) && genes_are(b, 0), "resize of a shared chrom");
+  CH_free(a);
+  CH_free(b);
+
+  /*--- A slab row: copy, free the slot, resize the copy ---*/
+  slab = CH_slab_alloc(2, 10, DT_BIT, FALSE);
+  a = CH_slab_get(slab);
+  b = CH_slab_get(slab);
+  fill(a, 1);
+  CH_copy(a, b);
+  CH_free(a);
+  CH_resize(b, 5000);
+  check(genes_are(b, 0), "resize of a sole holder of a slab row");
+  CH_free(b);
+  a = CH_slab_get(slab);
+  check(a != NULL, "slab slot given back");
+  CH_free(a);
+  CH_slab_free(slab);
+
+  /*--- Writing one copy leaves the others alone ---*/
+  a = CH_alloc(10);
+  b = CH_alloc(10);
+  c = CH_alloc(10);
+  fill(a, 1);
+  CH_copy(a, b);
+  CH_copy(a, c);
+  CH_own(b, TRUE);
+  fill(b, 2);
+  check(genes_are(a, 1) && genes_are(b, 2) && genes_are(c, 1),
+        "write of a shared chrom");
+  CH_free(a);
+  CH_free(c);
+  CH_free(b);
+
+  CH_spare_free();
+
+  if(failed) printf("%d checks failed\n", failed);
+  else printf("All checks passed\n");
+
+  return failed ? 1 : 0;
+}
+
+/*----------------------------------------------------------------------------
+| Report a failed check
+----------------------------------------------------------------------------*/
+int check(
+   int  ok,
+   char *what)
+{
+  if(!ok) {
+    printf("FAILED: %s\n", what);
+    failed++;
+  }
+
+  return ok;
+}
+
+/*----------------------------------------------------------------------------
+| Set all genes of an unpacked chrom to a value
+----------------------------------------------------------------------------*/
+int fill(
+   Chrom_Ptr chrom,
+   int       value)
+{
+  int i;
+
+  CH_own(chrom, FALSE);
+  for(i = 0; i < chrom->length; i++)
+    chrom->gene[i] = (Gene_Type)value;
+
+  return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Are all genes of a chrom a value?
+----------------------------------------------------------------------------*/
+int genes_are(
+   Chrom_Ptr chrom,
+   int       value)
+{
+  int i;
+
+  for(i = 0; i < chrom->length; i++)
+    if(CH_gene(chrom, i) != (Gene_Type)value) return FALSE;
+
+  return TRUE;
+}
+
+/*----------------------------------------------------------------------------
+| Objective function, not used
+----------------------------------------------------------------------------*/
+int obj_fun(
+   Chrom_Ptr chrom)
+{
+  return OK;
+}
@@ -10,9 +10,8 @@
 #include "ga.h"
 
 /* Global Variables*/
-char graph[500][500]; // could be optimised using malloc...
+Graph_Ptr graph = NULL, instance = NULL;
 int nnodes, nedges, prev_best;
-int read_once = 1;
 float best_x = 0, best_mu = 0;
 
 /* File variables */
@@ -21,6 +20,8 @@ Pool_Ptr rep_pool;
 
 /* Function prototypes */
 int obj_fun(Chrom_Ptr);
+int obj_delta(Chrom_Ptr);
+int set_fitness(Chrom_Ptr, int, int);
 int read_instance();
 
 /*----------------------------------------------------------------------------
@@ -44,13 +45,16 @@ int main()
   {
     /*--- Initialize the genetic algorithm ---*/
     ga_info = GA_config("GAconfig", obj_fun);
+    ga_info->DV_fun = obj_delta;
 
-    // Fill the matrix "graph" with all the info
+    // Fill the matrix "graph" with all the info, read only the first time
     // Also initialize nnodes and nedges
     read_instance(ga_info->user_data);
+    ga_info->graph = graph;
 
-    // Changing chromosome length
-    ga_info->chrom_len = nnodes;
+    // Reorder and prune the graph, also sets the chromosome length
+    GR_prepare(ga_info);
+    graph = ga_info->graph;
     ga_info->mu_rate = 0.6;
 
     /*--- Change the config ---*/
@@ -63,7 +67,7 @@ int main()
     count = 0;
     for (i = 0; i < ga_info->chrom_len; i++)
     {
-      if (ga_info->best->gene[i])
+      if (CH_gene(ga_info->best, i))
         count++;
     }
 
@@ -85,7 +89,6 @@ int main()
   }
 
   /*--- mu_rate variation ---*/
-  read_once = 1;
   prev_best = 1000;
 
   // Create .csv file
@@ -98,13 +101,16 @@ int main()
   {
     /*--- Initialize the genetic algorithm ---*/
     ga_info = GA_config("GAconfig", obj_fun);
+    ga_info->DV_fun = obj_delta;
 
-    // Fill the matrix "graph" with all the info
+    // Fill the matrix "graph" with all the info, read only the first time
     // Also initialize nnodes and nedges
     read_instance(ga_info->user_data);
+    ga_info->graph = graph;
 
-    // Changing chromosome length
-    ga_info->chrom_len = nnodes;
+    // Reorder and prune the graph, also sets the chromosome length
+    GR_prepare(ga_info);
+    graph = ga_info->graph;
     ga_info->x_rate = 0.6;
 
     /*--- Change the config ---*/
@@ -117,7 +123,7 @@ int main()
     count = 0;
     for (i = 0; i < ga_info->chrom_len; i++)
     {
-      if (ga_info->best->gene[i])
+      if (CH_gene(ga_info->best, i))
         count++;
     }
 
@@ -150,30 +156,33 @@ int main()
 ----------------------------------------------------------------------------*/
 int obj_fun(Chrom_Ptr chrom)
 {
-  int i, j;
-  double val = 0.0;
   int v = 0;
   int a = 0;
 
-  for (i = 0; i < chrom->length; i++)
-  {
-    v += chrom->gene[i];
-  }
+  // v = selected nodes, a = edges among them
+  GR_count(graph, chrom, &v, &a);
 
-  for (i = 0; i < chrom->length; i++)
-  {
-    if (chrom->gene[i] == 1)
-    {
-      for (j = i + 1; j < chrom->length; j++)
-      {
-        if (chrom->gene[j] == 1)
-        {
-          a += graph[i][j];
-        }
-      }
-    }
-  }
+  return set_fitness(chrom, v, a);
+}
+
+/*----------------------------------------------------------------------------
+| obj_delta() - objective function updated from the previous evaluation
+----------------------------------------------------------------------------*/
+int obj_delta(Chrom_Ptr chrom)
+{
+  int *st;
+
+  // st[0] = selected nodes, st[1] = edges among them
+  st = GR_delta(graph, chrom);
+
+  return set_fitness(chrom, st[0], st[1]);
+}
 
+/*----------------------------------------------------------------------------
+| set_fitness() - fitness of v selected nodes with a edges among them
+----------------------------------------------------------------------------*/
+int set_fitness(Chrom_Ptr chrom, int v, int a)
+{
   // Target functions
   int alpha = 1;
 
@@ -196,50 +205,22 @@ int obj_fun(Chrom_Ptr chrom)
 }
 
 /*----------------------------------------------------------------------------
-| read_instance() - read DIMACS format
+| read_instance() - load DIMACS format, once for every run
 ----------------------------------------------------------------------------*/
 int read_instance(char *filename)
 {
-  char dummy1;
-  char dummy2[100];
-  int dummy3;
-  int n1, n2;
-  FILE *inputf;
-  int i, j;
-
-  nnodes = 0;
-  nedges = 0;
-
-  if ((inputf = fopen(filename, "rt")) == NULL)
-  {
-    printf("Cannot open file %s\n", filename);
-    exit(-1);
-  }
-
-  // Read header
-  fscanf(inputf, "%c %s %d %d\n", &dummy1, dummy2, &nnodes, &nedges);
-
-  if (read_once)
+  if (instance == NULL)
   {
-    read_once = 0;
-    printf("Opening %s (%d nodes, %d edges)\n", filename, nnodes, nedges);
+    // Maps the compiled instance, compiling it the first time
+    instance = GR_load(filename);
+    printf("Opening %s (%d nodes, %d edges)\n", filename, instance->nnodes, instance->nedges);
   }
 
-  for (i = 0; i < nnodes; i++)
-    for (j = 0; j < nnodes; j++)
-      graph[i][j] = 0;
+  nnodes = instance->nnodes;
+  nedges = instance->nedges;
 
-  // Skip node list
-  for (i = 0; i < nnodes; i++)
-    fscanf(inputf, "%c  %d %d\n", &dummy1, &dummy3, &dummy3);
-
-  // Read all edges
-  for (i = 0; i < nedges; i++)
-  {
-    fscanf(inputf, "%c %d %d\n", &dummy1, &n1, &n2);
-    graph[n1 - 1][n2 - 1] = 1;
-    graph[n2 - 1][n1 - 1] = 1;
-  }
-
-  fclose(inputf);
-}
\ No newline at end of file
+  // Drop the preprocessed graph of the previous run
+  if (graph != NULL && graph != instance)
+    GR_free(graph);
+  graph = instance;
+}
@@ -9,7 +9,7 @@
 #include "ga.h"
 
 /* Global Variables*/
-char graph[500][500]; // could be optimised using malloc...
+Graph_Ptr graph = NULL, instance = NULL;
 int nnodes, nedges;
 
 /* File variables */
@@ -18,6 +18,8 @@ Pool_Ptr pool;
 
 /* Function prototypes */
 int obj_fun(Chrom_Ptr);
+int obj_delta(Chrom_Ptr);
+int set_fitness(Chrom_Ptr, int, int);
 int read_instance();
 
 /*----------------------------------------------------------------------------
@@ -26,17 +28,23 @@ int read_instance();
 int main()
 {
   GA_Info_Ptr ga_info;
+  Gene_Ptr best;
   int i, count = 0;
 
   /*--- Initialize the genetic algorithm ---*/
   ga_info = GA_config("GAconfig", obj_fun);
+  ga_info->DV_fun = obj_delta;
 
   // Fill the matrix "graph" with all the info
   // Also initialize nnodes and nedges
   read_instance(ga_info->user_data);
+  ga_info->graph = graph;
 
-  // Changing chromosome length
-  ga_info->chrom_len = nnodes;
+  // Reorder and prune the graph, also sets the chromosome length
+  GR_prepare(ga_info);
+  graph = ga_info->graph;
+  if (graph->nnodes != nnodes)
+    printf("Preprocessed to %d nodes, %d edges\n", graph->nnodes, graph->nedges);
 
   // Create and/or open the .csv file
   if ((fp = fopen("sim_stats.csv", "r")) == NULL)
@@ -53,14 +61,20 @@ int main()
   /*--- Run the GA ---*/
   GA_run(ga_info);
 
-  printf("\nBest chrom:  ");
+  // Best chrom in the node order of the instance
+  best = (Gene_Ptr)calloc(graph->norig, sizeof(Gene_Type));
   for (i = 0; i < ga_info->chrom_len; i++)
+    best[GR_orig(graph, i)] = CH_gene(ga_info->best, i);
+
+  printf("\nBest chrom:  ");
+  for (i = 0; i < graph->norig; i++)
   {
-    if (ga_info->best->gene[i])
+    if (best[i])
       count++;
 
-    printf("%5.0f  ", ga_info->best->gene[i]);
+    printf("%5.0f  ", best[i]);
   }
+  free(best);
 
   printf("   (fitness: %g)\n", ga_info->best->fitness);
   printf("Nodos: %d (fitness: %g)\n\n", count, ga_info->best->fitness);
@@ -80,30 +94,33 @@ int main()
 ----------------------------------------------------------------------------*/
 int obj_fun(Chrom_Ptr chrom)
 {
-  int i, j;
-  double val = 0.0;
   int v = 0;
   int a = 0;
 
-  for (i = 0; i < chrom->length; i++)
-  {
-    v += chrom->gene[i];
-  }
+  // v = selected nodes, a = edges among them
+  GR_count(graph, chrom, &v, &a);
 
-  for (i = 0; i < chrom->length; i++)
-  {
-    if (chrom->gene[i] == 1)
-    {
-      for (j = i + 1; j < chrom->length; j++)
-      {
-        if (chrom->gene[j] == 1)
-        {
-          a += graph[i][j];
-        }
-      }
-    }
-  }
+  return set_fitness(chrom, v, a);
+}
 
+/*----------------------------------------------------------------------------
+| obj_delta() - objective function updated from the previous evaluation
+----------------------------------------------------------------------------*/
+int obj_delta(Chrom_Ptr chrom)
+{
+  int *st;
+
+  // st[0] = selected nodes, st[1] = edges among them
+  st = GR_delta(graph, chrom);
+
+  return set_fitness(chrom, st[0], st[1]);
+}
+
+/*----------------------------------------------------------------------------
+| set_fitness() - fitness of v selected nodes with a edges among them
+----------------------------------------------------------------------------*/
+int set_fitness(Chrom_Ptr chrom, int v, int a)
+{
   // Target functions
   int alpha = 1;
 
@@ -126,46 +143,22 @@ int obj_fun(Chrom_Ptr chrom)
 }
 
 /*----------------------------------------------------------------------------
-| read_instance() - read DIMACS format
+| read_instance() - load DIMACS format, once for every run
 ----------------------------------------------------------------------------*/
 int read_instance(char *filename)
 {
-  char dummy1;
-  char dummy2[100];
-  int dummy3;
-  int n1, n2;
-  FILE *inputf;
-  int i, j;
-
-  nnodes = 0;
-  nedges = 0;
-
-  if ((inputf = fopen(filename, "rt")) == NULL)
+  if (instance == NULL)
   {
-    printf("Cannot open file %s\n", filename);
-    exit(-1);
+    // Maps the compiled instance, compiling it the first time
+    instance = GR_load(filename);
+    printf("Opening %s (%d nodes, %d edges)\n", filename, instance->nnodes, instance->nedges);
   }
 
-  // Read header
-  fscanf(inputf, "%c %s %d %d\n", &dummy1, dummy2, &nnodes, &nedges);
-
-  printf("Opening %s (%d nodes, %d edges)\n", filename, nnodes, nedges);
+  nnodes = instance->nnodes;
+  nedges = instance->nedges;
 
-  for (i = 0; i < nnodes; i++)
-    for (j = 0; j < nnodes; j++)
-      graph[i][j] = 0;
-
-  // Skip node list
-  for (i = 0; i < nnodes; i++)
-    fscanf(inputf, "%c  %d %d\n", &dummy1, &dummy3, &dummy3);
-
-  // Read all edges
-  for (i = 0; i < nedges; i++)
-  {
-    fscanf(inputf, "%c %d %d\n", &dummy1, &n1, &n2);
-    graph[n1 - 1][n2 - 1] = 1;
-    graph[n2 - 1][n1 - 1] = 1;
-  }
-
-  fclose(inputf);
-}
\ No newline at end of file
+  // Drop the preprocessed graph of the previous run
+  if (graph != NULL && graph != instance)
+    GR_free(graph);
+  graph = instance;
+}
@@ -23,6 +23,7 @@
 #include <math.h>
 #include <ctype.h>
 #include <string.h>
+#include <stdint.h>
 
 #if defined(__BORLANDC__)
 #include <process.h>
@@ -48,6 +49,7 @@
 #define DT_INT       1   /* Integers */
 #define DT_INT_PERM  2   /* Integer Permutation */
 #define DT_REAL      3   /* Reals */
+#define DT_PACKED_BIT 4  /* Bit string, 64 bits per word */
 
 /*--- Method to generate initial pool --- */
 #define IP_NONE         0x00
@@ -56,6 +58,25 @@
 #define IP_RANDOM       0x04
 #define IP_RANDOM01     0x05
 
+/*--- Random streams not tied to a trial (see RN_stream()) ---*/
+#define RN_INIT  -1   /* Iteration of the initial pool */
+#define RN_GAP   -1   /* Trial of the generation gap */
+#define RN_SELECT -2  /* Trial of batch selection */
+
+/*--- Changed loci remembered for delta evaluation ---*/
+#define CH_MAX_CHANGED  8
+
+/*--- Node order of a preprocessed graph ---*/
+#define GR_ORDER_NONE       0   /* File order */
+#define GR_ORDER_DEGREE     1   /* Most neighbours first */
+#define GR_ORDER_DEGENERACY 2   /* Reverse smallest-last order */
+#define GR_PRUNE_GREEDY    -1   /* Prune below a greedy clique */
+
+/*--- How often chroms of a trial are verified (see CH_check()) ---*/
+#define VA_FULL     0   /* Every chrom */
+#define VA_SAMPLED  1   /* One chrom in val_sample */
+#define VA_NONE     2   /* No chrom */
+
 /*--- Type of output report --- */
 #define RP_NONE    0
 #define RP_MINIMAL 1
@@ -67,6 +88,7 @@
 #define CF_cookie 0x11111111   /* ga_info (config) cookie */
 #define PL_cookie 0x22222222   /* pool cookie */
 #define CH_cookie 0x33333333   /* chrom cookie */
+#define GR_cookie 0x44444444   /* graph cookie */
 
 /*----------------------------------------------------------------------------
 | Type definitions 
@@ -83,10 +105,19 @@ typedef struct {
 /*--- A Gene (or allele) is a bit, int, float, etc. ---*/
 typedef double Gene_Type, *Gene_Ptr;
 
+/*--- A word of packed bits ---*/
+typedef uint64_t Word_Type, *Word_Ptr;
+
+/*--- A random number generator (xoshiro256**) ---*/
+typedef struct {
+   Word_Type  s[4];                 /* State, never all zero */
+} Rand_Type, *Rand_Ptr;
+
 /*--- A Chromosome ---*/
 typedef struct {
    long       magic_cookie;         /* For validation */
    Gene_Ptr   gene;                 /* Encoding */
+   Word_Ptr   bits;                 /* Encoding for DT_PACKED_BIT */
    int        length;               /* Length of gene */
    double     fitness;              /* Fitness value of chromosome */
    float      ptf;                  /* Percent of total fitness */
@@ -94,8 +125,42 @@ typedef struct {
    int        idx_min, idx_max;     /* Reserved */
    int        parent_1, parent_2;   /* Indices of parents */
    int        xp1, xp2;             /* Crossover points */
+   int        fit_valid;            /* Has fitness been evaluated? */
+   int        num_changed;          /* Loci changed since eval (-1 = all) */
+   int        changed[CH_MAX_CHANGED]; /* Loci changed since eval */
+   int        *ev_state;            /* State kept by delta evaluation */
+   int        ev_len;               /* Length of ev_state */
+   int        ev_valid;             /* Is ev_state up to date? */
+   struct CH_Slab *slab;            /* Slab holding chrom (or NULL) */
+   struct CH_Share *share;          /* Genes shared with others (or NULL) */
 } Chrom_Type, *Chrom_Ptr;
 
+/*--- Genes shared by chroms until one of them writes (copy on write) ---*/
+typedef struct CH_Share {
+   int        refs;                 /* Number of chroms holding the genes */
+   char       *mem;                 /* The genes */
+   size_t     size;                 /* Bytes in mem, if malloc'ed */
+   struct CH_Slab *slab;            /* Slab whose row mem is (or NULL) */
+   struct CH_Share *next;           /* Next spare malloc'ed genes */
+} CH_Share_Type, *CH_Share_Ptr;
+
+/*--- A slab of chromosome slots, all of one length and datatype ---*/
+typedef struct CH_Slab {
+   char       *mem;                 /* Slots, cache line aligned */
+   size_t     mem_size;             /* Bytes in mem */
+   int        mapped;               /* Is mem mapped (huge pages)? */
+   int        length;               /* Length of each chrom */
+   int        packed;               /* Packed genes [y/n]? */
+   Chrom_Ptr  head;                 /* Headers of all slots, contiguous */
+   char       *genes;               /* Gene matrix, one row per slot */
+   size_t     row_size;             /* Bytes per row */
+   int        num_slots;            /* Number of slots */
+   CH_Share_Ptr share;              /* Sharing of each row */
+   Chrom_Ptr  *free_list;           /* Slots not in use */
+   int        num_free;             /* Number of slots not in use */
+   int        orphan;               /* Release mem when all are back? */
+} CH_Slab_Type, *CH_Slab_Ptr;
+
 /*--- A Pool ---*/
 typedef struct {
    long       magic_cookie;                /* For validation */
@@ -107,8 +172,46 @@ typedef struct {
    int        best_index;                  /* Index of best chromosome */
    int        minimize;                    /* Minimize pool [y/n]? */
    int        sorted;                      /* Is pool sorted [y/n]? */
+   long       epoch;                       /* Bumped on every change */
+   long       sort_epoch;                  /* Epoch pool was last sorted at */
+   double     *wheel;                      /* Cumulative ptf, for roulette */
+   int        wheel_size;                  /* Chroms in wheel */
+   long       wheel_epoch;                 /* Epoch wheel was built at */
+   int        *pick;                       /* Batch of selections */
+   int        num_picks, next_pick;        /* Picks drawn, next one */
+   int        max_picks;                   /* Room in pick */
+   long       pick_epoch;                  /* Epoch picks were drawn at */
+   double     *rank_prob;                  /* Alias table, rank_biased */
+   int        *rank_alias;                 /* Alias of each rank */
+   int        rank_size;                   /* Pool size of the table */
+   float      rank_bias;                   /* Bias of the table */
+   CH_Slab_Ptr slab;                       /* Slots for chroms (or NULL) */
+   double     *fit;                        /* Fitness of each chrom */
+   long       fit_epoch;                   /* Epoch fit was gathered at */
+   long       stat_epoch;                  /* Epoch running stats are for */
+   int        stat_n;                      /* Chroms in running stats */
+   double     stat_mean, stat_m2;          /* Running mean, squares (Welford) */
+   int        stat_unsorted;               /* Adjacent chroms out of order */
+   int        *stat_min, *stat_max;        /* Trees of min/max chrom index */
+   int        stat_leaves;                 /* Leaves of the trees */
+   int        stat_lo, stat_hi;            /* Chroms swapped, not yet fixed */
+   int        stat_tlo, stat_thi;          /* Leaves not yet up the trees */
+   long       stat_updates;                /* Updates since the last pass */
 } Pool_Type, *Pool_Ptr;
 
+/*--- A graph (max clique instance) ---*/
+typedef struct {
+   long       magic_cookie;         /* For validation */
+   int        nnodes, nedges;       /* Number of nodes and edges */
+   int        nwords;               /* Words per adjacency row */
+   Word_Ptr   adj;                  /* Adjacency rows, packed bits */
+   int        norig;                /* Number of nodes in the instance */
+   int        *orig;                /* Instance node of each node (or NULL) */
+   int        *degree;              /* Degree of each node (or NULL) */
+   char       *map;                 /* Compiled file it is mapped from */
+   size_t     map_size;             /* Size of the mapping */
+} Graph_Type, *Graph_Ptr;
+
 /*--- GA configuration info ---*/
 typedef struct {
    /*--- Basic info ---*/
@@ -116,17 +219,30 @@ typedef struct {
    char  user_data[80];    /* User data file (unused) */
    int   function_index;   /* Index for the objetive function */
    int   rand_seed;        /* Seed for random number generator */
+   Rand_Type rng;          /* Random number generator */
    int   datatype;         /* Data type flag */
    int   ip_flag;          /* Initial pool generation method flag */
    char  ip_data[80];      /* Data file name (IP_FROM_FILE) */
    int   pool_size;        /* Pool size (IP_RANDOM) */
    int   chrom_len;        /* Chromosome size (IP_RANDOM) */
    int   iter, max_iter;   /* Number of iterations for ga */
+   int   trial;            /* Trial within the iteration */
    int   minimize;         /* Minimize EV_fun? */
    int   elitist;          /* Use elitism? */
    int   converged;        /* Has ga converged? */
    int   use_convergence;  /* Use convergence? */
+   int   use_delta;        /* Use delta evaluation? */
+   int   ev_threads;       /* Threads for batch evaluation */
+   int   cache_size;       /* Fitness cache entries (0 = no cache) */
+   int   huge_pages;       /* Back chrom slabs with huge pages? */
+   float ls_rate;          /* Local search rate */
+   int   ls_iter;          /* Local search move budget */
+   int   gr_order;         /* Graph node order (GR_ORDER_*) */
+   int   gr_prune;         /* Prune below clique size (0 = no) */
+   int   validation;       /* Chrom verification level (VA_*) */
+   int   val_sample;       /* Verify one chrom in so many (VA_SAMPLED) */
    float bias;             /* Selection bias */
+   int   tn_size;          /* Tournament size */
    float gap;              /* Generation gap */
    float x_rate;           /* Crossover rate */
    float mu_rate;          /* Mutation rate */
@@ -140,7 +256,9 @@ typedef struct {
    FN_Ptr   X_fun;    /* Crossover */
    FN_Ptr   MU_fun;   /* Mutation */
    FN_Ptr   EV_fun;   /* Evaluation */
+   FN_Ptr   DV_fun;   /* Delta evaluation (optional) */
    FN_Ptr   RE_fun;   /* Replacement */
+   FN_Ptr   LS_fun;   /* Local search (optional) */
 
    /*--- Reports ---*/
    int  rp_type;       /* Type of output report */
@@ -151,33 +269,117 @@ typedef struct {
    /*--- Pools ---*/
    Pool_Ptr old_pool, new_pool;
 
+   /*--- Problem graph, for clique operators (set by the user) ---*/
+   Graph_Ptr graph;
+
    /*--- Stats ---*/
    Chrom_Ptr  best;               /* Best chromosome */
    int        num_mut, tot_mut;   /* Mutation statistics */
+   long       tot_eval, tot_delta, tot_skip;   /* Evaluation statistics */
+   long       cache_hit, cache_miss, cache_evict;   /* Cache statistics */
+   long       tot_ls;             /* Local search statistics */
+   long       tot_copy, tot_trial;   /* Gene bytes copied, trials */
+   long       tot_verify, tot_unverified;   /* Chroms verified, skipped */
+
+   /*--- Evaluation threads and fitness cache (private) ---*/
+   void       *ev_pool;
+   void       *ev_cache;
+
+   /*--- Scratch of GA_batch() and EV_batch() (private) ---*/
+   Chrom_Ptr  *ev_parent, *ev_miss;   /* Parents, chroms to evaluate */
+   Word_Type  *ev_hash;               /* Hashes of ev_miss[] */
+   int        *ev_same;               /* Miss each chrom is a copy of */
+   int        ev_room;                /* Room in each */
 } GA_Info_Type, *GA_Info_Ptr;
 
 /*----------------------------------------------------------------------------
 | Pseudo-functions
 ----------------------------------------------------------------------------*/
-/*--- random number in [0..1] ---*/
-#if defined(__BORLANDC__)
-#define SEED_RAND(seed) (srand((seed)))
-#define RAND_FRAC() ((double)rand()/RAND_MAX)
-#else
-#define SEED_RAND(seed) (srand((seed)))
-#define RAND_FRAC() ((double)rand()*(1.0/RAND_MAX))
-#endif
+/*--- random number in [0..1), 53 bits ---*/
+#define SEED_RAND(rng, seed) (RN_seed((rng), (seed)))
+#define RAND_FRAC(rng) ((double)(RN_next(rng) >> 11) * (1.0/9007199254740992.0))
 
 /*--- random number in domain [lo..hi] ---*/
-#define RAND_DOM(lo,hi) ((int) floor(RAND_FRAC()*(((hi)-(lo))+0.999999))+(lo))
-//#define RAND_DOM(lo,hi) ((int) floor(RAND_FRAC()*((hi)-(lo)))+(lo))
+#define RAND_DOM(rng,lo,hi) ((int)RN_range((rng), (hi)-(lo)+1)+(lo))
+
 /*--- random bit ---*/
-#define RAND_BIT()  ((RAND_FRAC()>=.5)? 1 : 0 )
+#define RAND_BIT(rng)  ((int)(RN_next(rng) >> 63))
 
 /*--- min and max ---*/
 #define MIN(a,b) ((a < b) ? (a) : (b))
 //#define MAX(a,b) ((a > b) ? (a) : (b))
 
+/*--- packed bits ---*/
+#define WORD_BITS      64
+#define NUM_WORDS(n)   (((n) + WORD_BITS - 1) / WORD_BITS)
+#define BIT_TEST(w, i) (((w)[(i) / WORD_BITS] >> ((i) % WORD_BITS)) & 1)
+#define BIT_SET(w, i)  ((w)[(i) / WORD_BITS] |= (Word_Type)1 << ((i) % WORD_BITS))
+#define BIT_CLR(w, i)  ((w)[(i) / WORD_BITS] &= ~((Word_Type)1 << ((i) % WORD_BITS)))
+#if defined(__GNUC__)
+#define POPCOUNT(w)    __builtin_popcountll(w)
+#define LOWBIT(w)      __builtin_ctzll(w)
+#else
+#define POPCOUNT(w)    UT_popcount(w)
+#define LOWBIT(w)      UT_popcount(((w) & -(w)) - 1)
+#endif
+
+/*--- genes of a chrom, packed or not ---*/
+#define CH_packed(chrom)  ((chrom)->bits != NULL)
+#define CH_gene(chrom, i) (CH_packed(chrom) ? \
+                           (Gene_Type)BIT_TEST((chrom)->bits, i) : (chrom)->gene[i])
+
+/*--- does a chrom need to be evaluated? ---*/
+#define CH_dirty(chrom)   (!(chrom)->fit_valid || (chrom)->num_changed != 0)
+
+/*--- note that a pool (or the fitness in it) has changed ---*/
+#define PL_touch(pool)    (++(pool)->epoch)
+
+/*--- adjacency row of node i ---*/
+#define GR_row(graph, i) ((graph)->adj + (size_t)(i) * (graph)->nwords)
+
+/*--- instance node of node i ---*/
+#define GR_orig(graph, i) ((graph)->orig != NULL ? (graph)->orig[i] : (i))
+
+/*--- next random word, xoshiro256** ---*/
+static inline Word_Type RN_next(Rand_Ptr rng)
+{
+   Word_Type *s = rng->s;
+   Word_Type x  = s[1] * 5;
+   Word_Type r  = ((x << 7) | (x >> 57)) * 9;
+   Word_Type t  = s[1] << 17;
+
+   s[2] ^= s[0];
+   s[3] ^= s[1];
+   s[1] ^= s[2];
+   s[0] ^= s[3];
+   s[2] ^= t;
+   s[3]  = (s[3] << 45) | (s[3] >> 19);
+
+   return r;
+}
+
+/*--- random integer in [0..n-1], Lemire's multiply and shift ---*/
+static inline int RN_range(Rand_Ptr rng, int n)
+{
+   uint64_t m;
+   uint32_t lo, bound;
+
+   if(n <= 1) return 0;
+   bound = (uint32_t)n;
+   m  = (RN_next(rng) >> 32) * bound;
+   lo = (uint32_t)m;
+   if(lo < bound) {
+      /*--- Reject the few draws that would bias the result ---*/
+      uint32_t t = (0u - bound) % bound;
+      while(lo < t) {
+         m  = (RN_next(rng) >> 32) * bound;
+         lo = (uint32_t)m;
+      }
+   }
+
+   return (int)(m >> 32);
+}
+
 #define UT_warn(message) {fprintf(stderr,"WARNING: %s\n", message);}
 #define UT_error(message) {fprintf(stderr,"GA_ERROR: %s\n", message); exit(1);}
 #define UT_iswap(a, b) {int tmp; tmp = *(a); *(a) = *(b); *(b) = tmp;}
@@ -190,11 +392,58 @@ extern "C" {
 /*----------------------------------------------------------------------------
 | Function prototypes
 ----------------------------------------------------------------------------*/
-char *GA_name(), *SE_name(), *X_name(), *MU_name(), *RE_name();
+char *GA_name(), *SE_name(), *X_name(), *MU_name(), *RE_name(), *LS_name();
 char *FN_name();
 
 Chrom_Ptr SE_fun(), CH_alloc();
+Chrom_Ptr CH_alloc_type(int length, int datatype);
+int CH_equal(Chrom_Ptr a, Chrom_Ptr b);
+Word_Type CH_hash(Chrom_Ptr chrom);
+int CH_rand_bits(Chrom_Ptr chrom, Rand_Ptr rng);
+int *CH_ev_state(Chrom_Ptr chrom, int len);
+int CH_changed(Chrom_Ptr chrom, int locus);
+int CH_own(Chrom_Ptr chrom, int keep);
+int CH_check(GA_Info_Ptr ga_info, Chrom_Ptr chrom);
+CH_Slab_Ptr CH_slab_alloc(int num_slots, int length, int datatype, int huge);
+Chrom_Ptr CH_slab_get(CH_Slab_Ptr slab);
+int CH_slab_free(CH_Slab_Ptr slab);
+int CH_spare_free(void);
+Chrom_Ptr PL_new_chrom(Pool_Ptr pool, int length, int datatype);
+int PL_slab(Pool_Ptr pool, int length, int datatype, int huge);
+double *PL_fitness(Pool_Ptr pool);
+int PL_append_move(Pool_Ptr pool, Chrom_Ptr *chrom);
+int RE_move(GA_Info_Ptr ga_info, Pool_Ptr pool, Chrom_Ptr p1, Chrom_Ptr p2,
+            Chrom_Ptr *c1, Chrom_Ptr *c2);
+int EV_fun(GA_Info_Ptr ga_info, Chrom_Ptr chrom);
+int EV_batch(GA_Info_Ptr ga_info, Chrom_Ptr *chrom, int n);
+int EV_stop(GA_Info_Ptr ga_info);
+int EV_cache_free(GA_Info_Ptr ga_info);
 Pool_Ptr PL_alloc();
+Graph_Ptr GR_alloc(int nnodes);
+int GR_free(Graph_Ptr graph);
+int GR_valid(Graph_Ptr graph);
+int GR_add_edge(Graph_Ptr graph, int u, int v);
+int GR_count(Graph_Ptr graph, Chrom_Ptr chrom, int *v, int *a);
+int *GR_delta(Graph_Ptr graph, Chrom_Ptr chrom);
+int GR_degree(Graph_Ptr graph, int i);
+int GR_greedy(Graph_Ptr graph);
+int GR_degeneracy(Graph_Ptr graph, int k, int *order);
+Graph_Ptr GR_subgraph(Graph_Ptr graph, int *nodes, int n);
+int GR_prepare(GA_Info_Ptr ga_info);
+Graph_Ptr GR_read(char *filename);
+Graph_Ptr GR_load(char *filename);
+Graph_Ptr GR_map(char *filename, char *source, int verify);
+int GR_write(Graph_Ptr graph, char *filename, char *source);
+int UT_popcount(Word_Type w);
+int RN_seed(Rand_Ptr rng, unsigned long seed);
+int RN_stream(Rand_Ptr rng, int seed, int iter, int trial);
+int RN_philox(uint32_t ctr[4], uint32_t key[2], uint32_t out[4]);
+int RN_bits(Rand_Ptr rng, Word_Ptr out, int n);
+int RN_fracs(Rand_Ptr rng, double *out, int n);
+char *UT_map_file(char *filename, size_t *size);
+int UT_unmap_file(char *buf, size_t size);
+int UT_file_stamp(char *filename, long *size, long *mtime);
+Word_Type UT_checksum(void *buf, size_t nwords);
 GA_Info_Ptr GA_config(char *cfg_name,int  (*EV_fun)(Chrom_Ptr chrom));
 GA_Info_Ptr CF_alloc();
 //extern int obj_fun(   Chrom_Ptr chrom);
@@ -202,6 +451,7 @@ int GA_run(  GA_Info_Ptr ga_info);
 int GA_init_trial(GA_Info_Ptr ga_info);
 int GA_gap(GA_Info_Ptr ga_info);
 void GA_trial(GA_Info_Ptr ga_info);
+int GA_batch(GA_Info_Ptr ga_info);
 void GA_gen_init(GA_Info_Ptr ga_info);
 void GA_reset(GA_Info_Ptr ga_info,  char *cfg_name);
 void re_evaluate_pop(GA_Info_Ptr ga_info);
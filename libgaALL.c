@@ -8,14 +8,37 @@
 |
 | Functions:
 |    CH_alloc()  - allocate a chrom
+|    CH_alloc_type() - allocate a chrom for a datatype
 |    CH_resize() - resize a chrom
 |    CH_free()   - deallocate a chrom
 |    CH_valid()  - is a chrom valid?
 |    CH_reset()  - reset a chrom
+|    CH_reset_info() - reset a chrom, but not its genes
 |    CH_copy()   - copy a chrom over another
 |    CH_cmp()    - compare two chromosomes
+|    CH_equal()  - do two chromosomes have the same genes?
+|    CH_hash()   - 64 bit hash of the genes
 |    CH_print()  - print a chrom
 |    CH_verify() - ensure chrom makes sense
+|    CH_check()  - verify a chrom as often as the validation level asks
+|    CH_changed()  - record a changed locus for delta evaluation
+|    CH_ev_state() - get room for delta evaluation state
+|    CH_rand_bits() - random packed genes
+|    CH_slab_alloc() - allocate a slab of chrom slots
+|    CH_slab_get()   - take a chrom from a slab
+|    CH_slab_put()   - give a chrom back to its slab (CH_free() does it)
+|    CH_slab_free()  - deallocate a slab
+|    CH_heap_genes() - were the genes of a chrom malloc'ed?
+|    CH_share()      - make the genes of a chrom shareable
+|    CH_own()        - make shared genes of a chrom its own, to write them
+|    CH_drop()       - let go of the genes of a chrom
+|    CH_new_genes()  - give a chrom genes of its own
+|    CH_spare_free() - deallocate the spare genes let go of by chroms
+|
+| NOTE: DT_PACKED_BIT chroms keep their genes in bits[], 64 per word, and
+|       have no gene[].  Unused bits of the last word are always zero, so
+|       whole words can be copied and compared.  Use CH_gene() to read a
+|       gene of either kind.
 ============================================================================*/
 
 
@@ -26,31 +49,103 @@
 /* Number of chromosome pointers to alloc at a time */
 #define PL_ALLOC_SIZE 10 
 
+/* Running pool stats get a full pass after this many updates per chrom */
+#define PL_STAT_PASS 16
+
+/* Alignment of chrom slab slots, a cache line */
+#define CH_SLAB_ALIGN 64
+#define CH_SLAB_ROUND(n) (((n) + CH_SLAB_ALIGN - 1) & ~(size_t)(CH_SLAB_ALIGN - 1))
+
+/* Row of the gene matrix of a slab for a chrom of the slab */
+#define CH_SLAB_ROW(slab, chrom) \
+   ((slab)->genes + (size_t)((chrom) - (slab)->head) * (slab)->row_size)
+
+/* Slot number of a chrom of a slab */
+#define CH_SLAB_SLOT(slab, chrom) ((int)((chrom) - (slab)->head))
+
+/* posix_memalign() and MAP_ANONYMOUS are not in strict ANSI C */
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE
+#endif
+
 
 #include "ga.h"
 
+#ifndef GA_NO_THREADS
+#include <pthread.h>
+#endif
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+#ifndef GA_NO_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
 
 
 int GA_generational(), GA_steady_state();
+int GA_picks(GA_Info_Ptr);
 
 static Chrom_Ptr child1, child2;
 
+/*--- Gene bytes copied by CH_copy() since GA_run() started ---*/
+static long CH_copied;
+
+/*--- Malloc'ed genes let go of by all chroms, kept for CH_new_genes() ---*/
+static CH_Share_Ptr CH_spare;
+
+/*--- Allele counts of CH_verify(), kept between calls ---*/
+static char *CH_allele;
+static int  CH_allele_len;
+
 
 int X_simple(), X_uniform(), X_order1(), X_order2(), X_pos(), X_cycle(), 
     X_pmx(), X_uox(), X_rox(), X_asex();
+int X_check_packed(Chrom_Ptr, Chrom_Ptr, Chrom_Ptr, Chrom_Ptr);
+int X_mix_word(Chrom_Ptr, Chrom_Ptr, Chrom_Ptr, Chrom_Ptr, int, Word_Type);
 
 
 int MU_simple_invert(), MU_simple_random(), MU_swap();
  /* rnd float in [0..1] -- introduced by claudio 10/02/2004 */
 int MU_float_random(), MU_float_rnd_pert(), MU_float_LS(), MU_float_gauss_pert();
 
-double gaussian_random(void);
+double gaussian_random(Rand_Ptr rng);
 
 int obj_fun(   Chrom_Ptr chrom);
 
 int RE_append(), RE_by_rank(), RE_first_weaker(), RE_weakest();
 
-int SE_uniform_random(), SE_roulette(), SE_rank_biased();
+int EV_count(GA_Info_Ptr, Chrom_Ptr), EV_call(GA_Info_Ptr, Chrom_Ptr);
+int EV_run(GA_Info_Ptr, Chrom_Ptr *, int);
+int EV_room(GA_Info_Ptr, int);
+int EV_lookup(GA_Info_Ptr, Chrom_Ptr, Word_Type *);
+int EV_store(GA_Info_Ptr, Chrom_Ptr, Word_Type);
+int EV_take(Chrom_Ptr, double);
+
+int SE_uniform_random(), SE_roulette(), SE_rank_biased(), SE_sus();
+int SE_tournament();
+int SE_wheel(GA_Info_Ptr, Pool_Ptr), SE_spin(Pool_Ptr, double);
+int SE_batch(GA_Info_Ptr, Pool_Ptr, int);
+int SE_rank_table(GA_Info_Ptr, Pool_Ptr);
+
+int CH_reset_info(Chrom_Ptr);
+int CH_slab_put(Chrom_Ptr), CH_heap_genes(Chrom_Ptr);
+int CH_share(Chrom_Ptr), CH_drop(Chrom_Ptr), CH_new_genes(Chrom_Ptr, int);
+
+int PL_stats_build(Pool_Ptr), PL_stats_check(Pool_Ptr), PL_stats_fix(Pool_Ptr, int);
+int PL_stats_out(Pool_Ptr, int, int), PL_stats_in(Pool_Ptr, int, int);
+int PL_stats_first(Pool_Ptr, int);
+int PL_weakest(GA_Info_Ptr, Pool_Ptr), PL_in_order(GA_Info_Ptr, Pool_Ptr);
+int PL_first_weaker(GA_Info_Ptr, Pool_Ptr, Chrom_Ptr), PL_shift(Pool_Ptr, int, int);
+
+int LS_clique(), LS_fun(), LS_select(), LS_set_fun();
+int LS_clique_add(Graph_Ptr, Word_Ptr, int);
+int GR_parse_int(char **, char *);
 
 
 
@@ -84,6 +179,39 @@ Chrom_Ptr CH_alloc(
    return chrom;
 }
 
+/*----------------------------------------------------------------------------
+| Allocate a chromosome for a datatype
+----------------------------------------------------------------------------*/
+Chrom_Ptr CH_alloc_type(
+   int length,
+   int datatype)
+{
+   Chrom_Ptr chrom;
+
+   /*--- Unpacked genes ---*/
+   if(datatype != DT_PACKED_BIT) return CH_alloc(length);
+
+   /*--- Error check ---*/
+   if(length <= 0) UT_error("CH_alloc_type: invalid length");
+
+   /*--- Allocate memory for chromosome ---*/
+   chrom = (Chrom_Ptr)calloc(1, sizeof(Chrom_Type));
+   if(chrom == NULL) UT_error("CH_alloc_type: chrom alloc failed");
+   chrom->length = length;
+
+   /*--- Allocate memory for packed genes ---*/
+   chrom->bits = (Word_Ptr)calloc(NUM_WORDS(length), sizeof(Word_Type));
+   if(chrom->bits == NULL) UT_error("CH_alloc_type: bits alloc failed");
+
+   /*--- Put in magic cookie ---*/
+   chrom->magic_cookie = CH_cookie;
+
+   /*--- Reset the chromosome ---*/
+   CH_reset(chrom);
+
+   return chrom;
+}
+
 /*----------------------------------------------------------------------------
 | Resize a chromosome
 |
@@ -94,14 +222,19 @@ CH_resize(
    Chrom_Ptr chrom,
    int       length)
 {
+   int packed;
+
    /*--- Error check ---*/
    if(!CH_valid(chrom)) UT_error("CH_resize: invalid chrom");
    if(length <= 0) UT_error("CH_resize: invalid length");
 
-   /*--- Reallocate memory for genes ---*/
-   chrom->gene = (Gene_Ptr)realloc(chrom->gene, length * sizeof(Gene_Type));
-   if(chrom->gene == NULL) UT_error("CH_resize: gene realloc failed");
+   /*--- Let go of the genes, shared or not, they are reset anyway ---*/
+   packed = CH_packed(chrom);
+   CH_drop(chrom);
+
+   /*--- Genes of the new length ---*/
    chrom->length = length;
+   CH_new_genes(chrom, packed);
 
    /*--- Reset the chromosome ---*/
    CH_reset(chrom);
@@ -116,19 +249,393 @@ CH_free(
    /*--- Error check ---*/
   if(!CH_valid(chrom)) return 0;  //CC
 
-   /*--- Free memory for genes ---*/
-   if(chrom->gene != NULL) {
-      free(chrom->gene);
-      chrom->gene = NULL;
+   /*--- Free memory for genes, unless in a slab slot or still shared ---*/
+   CH_drop(chrom);
+
+   /*--- Free memory for evaluation state ---*/
+   if(chrom->ev_state != NULL) {
+      free(chrom->ev_state);
+      chrom->ev_state = NULL;
    }
 
    /*--- Put in NULL magic cookie ---*/
    chrom->magic_cookie = NL_cookie;
 
    /*--- Free memory for chromosome ---*/
-   free(chrom);
+   if(chrom->slab != NULL)
+      CH_slab_put(chrom);
+   else
+      free(chrom);
+}
+
+/*----------------------------------------------------------------------------
+| Allocate a slab of num_slots chroms of a length and datatype
+|
+| NOTE: The slab is laid out as structure of arrays: the headers of all
+|       slots side by side, so scans of the fitness of a pool stream
+|       through memory, then the genes as a matrix with a row per slot,
+|       each row on a cache line boundary.  With huge set the slab is
+|       mapped and the kernel asked for huge pages.
+----------------------------------------------------------------------------*/
+CH_Slab_Ptr CH_slab_alloc(
+   int num_slots,
+   int length,
+   int datatype,
+   int huge)
+{
+   CH_Slab_Ptr slab;
+   size_t      head_size;
+   int         i;
+
+   /*--- Error check ---*/
+   if(num_slots <= 0) UT_error("CH_slab_alloc: invalid num_slots");
+   if(length <= 0) UT_error("CH_slab_alloc: invalid length");
+
+   /*--- Allocate memory for slab ---*/
+   slab = (CH_Slab_Ptr)calloc(1, sizeof(CH_Slab_Type));
+   if(slab == NULL) UT_error("CH_slab_alloc: slab alloc failed");
+   slab->length    = length;
+   slab->packed    = (datatype == DT_PACKED_BIT);
+   slab->num_slots = num_slots;
+
+   /*--- Size of the headers and of a row of genes ---*/
+   head_size = CH_SLAB_ROUND(num_slots * sizeof(Chrom_Type));
+   if(slab->packed)
+      slab->row_size = CH_SLAB_ROUND(NUM_WORDS(length) * sizeof(Word_Type));
+   else
+      slab->row_size = CH_SLAB_ROUND(length * sizeof(Gene_Type));
+   slab->mem_size  = head_size + slab->row_size * num_slots;
+
+   /*--- Allocate memory for slots ---*/
+   slab->mem = NULL;
+#ifndef GA_NO_MMAP
+   if(huge) {
+      slab->mem = mmap(NULL, slab->mem_size, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if(slab->mem == MAP_FAILED) {
+         slab->mem = NULL;
+      } else {
+         slab->mapped = TRUE;
+#ifdef MADV_HUGEPAGE
+         madvise(slab->mem, slab->mem_size, MADV_HUGEPAGE);
+#endif
+      }
+   }
+#endif
+   if(slab->mem == NULL) {
+      if(posix_memalign((void **)&slab->mem, CH_SLAB_ALIGN, slab->mem_size))
+         UT_error("CH_slab_alloc: mem alloc failed");
+   }
+
+   slab->head  = (Chrom_Ptr)slab->mem;
+   slab->genes = slab->mem + head_size;
+
+   /*--- All slots are free, first slot on top ---*/
+   slab->free_list = (Chrom_Ptr *)malloc(num_slots * sizeof(Chrom_Ptr));
+   if(slab->free_list == NULL) UT_error("CH_slab_alloc: free_list alloc failed");
+   for(i = 0; i < num_slots; i++) {
+      slab->head[i].magic_cookie = NL_cookie;
+      slab->free_list[i] = &slab->head[num_slots-1 - i];
+   }
+   slab->num_free = num_slots;
+
+   /*--- No row is shared yet ---*/
+   slab->share = (CH_Share_Ptr)calloc(num_slots, sizeof(CH_Share_Type));
+   if(slab->share == NULL) UT_error("CH_slab_alloc: share alloc failed");
+   for(i = 0; i < num_slots; i++) {
+      slab->share[i].mem  = CH_SLAB_ROW(slab, &slab->head[i]);
+      slab->share[i].slab = slab;
+   }
+
+   return slab;
+}
+
+/*----------------------------------------------------------------------------
+| Take a chrom from a slab, NULL if all slots are in use
+----------------------------------------------------------------------------*/
+Chrom_Ptr CH_slab_get(
+   CH_Slab_Ptr slab)
+{
+   Chrom_Ptr chrom;
+
+   /*--- Error check ---*/
+   if(slab == NULL) UT_error("CH_slab_get: NULL slab");
+
+   /*--- Slab full ---*/
+   if(slab->num_free <= 0 || slab->orphan) return NULL;
+
+   /*--- Header and row of genes of the slot ---*/
+   chrom = slab->free_list[--slab->num_free];
+   memset(chrom, 0, sizeof(Chrom_Type));
+   chrom->length = slab->length;
+   chrom->slab   = slab;
+   if(slab->packed)
+      chrom->bits = (Word_Ptr)CH_SLAB_ROW(slab, chrom);
+   else
+      chrom->gene = (Gene_Ptr)CH_SLAB_ROW(slab, chrom);
+
+   /*--- Put in magic cookie ---*/
+   chrom->magic_cookie = CH_cookie;
+
+   /*--- Reset the chromosome ---*/
+   CH_reset(chrom);
+
+   return chrom;
+}
+
+/*----------------------------------------------------------------------------
+| Give a chrom back to its slab
+|
+| NOTE: Called by CH_free() once the genes and evaluation state are gone.
+|       While other chroms still share its row of genes, the slot is held 
+|       back; CH_drop() gives it back with the last of them.
+----------------------------------------------------------------------------*/
+int CH_slab_put(
+   Chrom_Ptr chrom)
+{
+   CH_Slab_Ptr slab = chrom->slab;
+
+   /*--- Row of genes still shared ---*/
+   if(slab->share[CH_SLAB_SLOT(slab, chrom)].refs > 0) return OK;
+
+   /*--- Error check ---*/
+   if(slab->num_free >= slab->num_slots) UT_error("CH_slab_put: slab full");
+
+   slab->free_list[slab->num_free++] = chrom;
+
+   /*--- Last chrom of a freed slab ---*/
+   if(slab->orphan && slab->num_free == slab->num_slots) {
+      slab->orphan = FALSE;
+      CH_slab_free(slab);
+   }
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| De-Allocate a slab
+|
+| NOTE: If some of its chroms are still in use, the slab is only released
+|       when the last one is freed
+----------------------------------------------------------------------------*/
+int CH_slab_free(
+   CH_Slab_Ptr slab)
+{
+   /*--- Error check ---*/
+   if(slab == NULL) return GA_ERROR;
+
+   /*--- Chroms still out ---*/
+   if(slab->num_free < slab->num_slots) {
+      slab->orphan = TRUE;
+      return OK;
+   }
+
+   /*--- Release memory for slots ---*/
+#ifndef GA_NO_MMAP
+   if(slab->mapped)
+      munmap(slab->mem, slab->mem_size);
+   else
+#endif
+      free(slab->mem);
+   free(slab->free_list);
+   free(slab->share);
+   free(slab);
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Were the genes of a chrom malloc'ed (not in a slab slot)?
+----------------------------------------------------------------------------*/
+int CH_heap_genes(
+   Chrom_Ptr chrom)
+{
+   char *genes;
+
+   if(chrom->slab == NULL) return TRUE;
+
+   genes = chrom->bits != NULL ? (char *)chrom->bits : (char *)chrom->gene;
+   return genes != CH_SLAB_ROW(chrom->slab, chrom);
+}
+
+/*----------------------------------------------------------------------------
+| Make the genes of a chrom shareable with other chroms
+|
+| NOTE: A row of a slab has its share in the slab, genes from CH_new_genes()
+|       come with one.  Only genes malloc'ed elsewhere (CH_alloc()) get a new
+|       share, once.  Either way no gene is copied.
+----------------------------------------------------------------------------*/
+int CH_share(
+   Chrom_Ptr chrom)
+{
+   CH_Share_Ptr share;
+
+   /*--- Already shareable ---*/
+   if(chrom->share != NULL) return OK;
+
+   if(CH_heap_genes(chrom)) {
+      share = (CH_Share_Ptr)malloc(sizeof(CH_Share_Type));
+      if(share == NULL) UT_error("CH_share: share alloc failed");
+      share->mem  = CH_packed(chrom) ? (char *)chrom->bits : (char *)chrom->gene;
+      share->size = CH_packed(chrom) ? NUM_WORDS(chrom->length) * sizeof(Word_Type)
+                                     : chrom->length * sizeof(Gene_Type);
+      share->slab = NULL;
+      share->next = NULL;
+   } else {
+      share = &chrom->slab->share[CH_SLAB_SLOT(chrom->slab, chrom)];
+   }
+   share->refs  = 1;
+   chrom->share = share;
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Make the genes of a chrom its own before writing them (copy on write)
+|
+| NOTE: Genes shared with other chroms are left to them, the chrom gets new
+|       ones from CH_new_genes().  The genes are copied over only if keep is
+|       set, callers about to overwrite all of them pass FALSE.  The last 
+|       holder of shared genes just keeps them.
+----------------------------------------------------------------------------*/
+int CH_own(
+   Chrom_Ptr chrom,
+   int       keep)
+{
+   CH_Share_Ptr share = chrom->share;
+   size_t       size;
+
+   /*--- Not shared with anyone ---*/
+   if(share == NULL || share->refs <= 1) return OK;
+
+   /*--- Leave the shared genes to the others ---*/
+   share->refs--;
+   CH_new_genes(chrom, CH_packed(chrom));
+
+   /*--- Copy the genes ---*/
+   if(keep) {
+      if(CH_packed(chrom))
+         size = NUM_WORDS(chrom->length) * sizeof(Word_Type);
+      else
+         size = chrom->length * sizeof(Gene_Type);
+      memcpy(CH_packed(chrom) ? (char *)chrom->bits : (char *)chrom->gene,
+             share->mem, size);
+      CH_copied += size;
+   }
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Let go of the genes of a chrom
+|
+| NOTE: Shared genes are released by their last holder: malloc'ed ones are
+|       kept as spares for CH_new_genes(), a row of a slab whose slot was 
+|       freed meanwhile gives the slot back to the slab.
+----------------------------------------------------------------------------*/
+int CH_drop(
+   Chrom_Ptr chrom)
+{
+   CH_Share_Ptr share = chrom->share;
+   CH_Slab_Ptr  slab;
+   Chrom_Ptr    head;
+
+   /*--- Own genes, free unless in a slab slot ---*/
+   if(share == NULL) {
+      if(CH_heap_genes(chrom)) {
+         if(chrom->gene != NULL) free(chrom->gene);
+         if(chrom->bits != NULL) free(chrom->bits);
+      }
+   } 
+
+   /*--- Shared genes, the last holder releases them ---*/
+   else if(--share->refs == 0) {
+      if((slab = share->slab) == NULL) {
+         share->next = CH_spare;
+         CH_spare    = share;
+      } else {
+         head = &slab->head[share - slab->share];
+         if(head->magic_cookie != CH_cookie) CH_slab_put(head);
+      }
+   }
+
+   chrom->share = NULL;
+   chrom->gene  = NULL;
+   chrom->bits  = NULL;
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Give a chrom genes of its own, not yet written
+|
+| NOTE: The chrom gets the row of its slot if free, else spare genes let go
+|       of by another chrom, else new ones malloc'ed with their share.  Its
+|       old genes must have been let go of already.
+----------------------------------------------------------------------------*/
+int CH_new_genes(
+   Chrom_Ptr chrom,
+   int       packed)
+{
+   CH_Slab_Ptr  slab = chrom->slab;
+   CH_Share_Ptr share;
+   char         *genes;
+   size_t       size;
+
+   if(packed)
+      size = NUM_WORDS(chrom->length) * sizeof(Word_Type);
+   else
+      size = chrom->length * sizeof(Gene_Type);
+
+   /*--- Row of its slot ---*/
+   if(slab != NULL && slab->length == chrom->length &&
+      slab->packed == packed &&
+      slab->share[CH_SLAB_SLOT(slab, chrom)].refs == 0) {
+      share = NULL;
+      genes = CH_SLAB_ROW(slab, chrom);
+   } else {
+      /*--- Spares of another size are of no more use ---*/
+      if(CH_spare != NULL && CH_spare->size != size) CH_spare_free();
+
+      /*--- Spare genes, else new ones ---*/
+      if(CH_spare != NULL) {
+         share    = CH_spare;
+         CH_spare = share->next;
+      } else {
+         share = (CH_Share_Ptr)malloc(sizeof(CH_Share_Type));
+         if(share == NULL) UT_error("CH_new_genes: share alloc failed");
+         share->mem = (char *)malloc(size);
+         if(share->mem == NULL) UT_error("CH_new_genes: genes alloc failed");
+         share->size = size;
+         share->slab = NULL;
+      }
+      share->refs = 1;
+      share->next = NULL;
+      genes = share->mem;
+   }
+
+   chrom->share = share;
+   chrom->gene  = packed ? NULL : (Gene_Ptr)genes;
+   chrom->bits  = packed ? (Word_Ptr)genes : NULL;
+
+   return OK;
 }
 
+/*----------------------------------------------------------------------------
+| De-Allocate the spare genes let go of by chroms
+----------------------------------------------------------------------------*/
+int CH_spare_free(void)
+{
+   CH_Share_Ptr share;
+
+   while((share = CH_spare) != NULL) {
+      CH_spare = share->next;
+      free(share->mem);
+      free(share);
+   }
+
+   return OK;
+}
 /*----------------------------------------------------------------------------
 | Is a chromosome valid, i.e., has it been allocated by CH_alloc()?
 ----------------------------------------------------------------------------*/
@@ -137,7 +644,7 @@ CH_valid(
 {
    /*--- Check for NULL pointers ---*/
    if(chrom == NULL) return FALSE;
-   if(chrom->gene == NULL) return FALSE;
+   if(chrom->gene == NULL && chrom->bits == NULL) return FALSE;
 
    /*--- Check for magic cookie ---*/
    if(chrom->magic_cookie != CH_cookie) return FALSE;
@@ -158,8 +665,26 @@ CH_reset(
    if(!CH_valid(chrom)) UT_error("CH_reset: invalid chrom");
 
    /*--- Initialize genes ---*/
-   for(i=0; i<chrom->length; i++)
-      chrom->gene[i] = (Gene_Type)0;
+   CH_own(chrom, FALSE);
+   if(CH_packed(chrom))
+      memset(chrom->bits, 0, NUM_WORDS(chrom->length) * sizeof(Word_Type));
+   else
+      for(i=0; i<chrom->length; i++)
+         chrom->gene[i] = (Gene_Type)0;
+
+   /*--- Initialize chromosome ---*/
+   CH_reset_info(chrom);
+}
+
+/*----------------------------------------------------------------------------
+| Reset everything but the genes of a chromosome, for callers about to 
+| overwrite every gene anyway
+----------------------------------------------------------------------------*/
+int CH_reset_info(
+   Chrom_Ptr chrom)
+{
+   /*--- Error check ---*/
+   if(!CH_valid(chrom)) UT_error("CH_reset_info: invalid chrom");
 
    /*--- Initialize chromosome ---*/
    chrom->fitness  = 0.0;
@@ -171,34 +696,58 @@ CH_reset(
    chrom->parent_2 = -1;
    chrom->xp1      = -1;
    chrom->xp2      = -1;
+
+   /*--- Everything changed, fitness and evaluation state are stale ---*/
+   chrom->fit_valid   = FALSE;
+   chrom->num_changed = -1;
+   chrom->ev_valid    = FALSE;
+
+   return OK;
 }
 
 /*----------------------------------------------------------------------------
 | Copy a chromosome
+|
+| NOTE: The genes are not copied, dst shares them with src until either 
+|       writes them (see CH_own())
 ----------------------------------------------------------------------------*/
 CH_copy(
    Chrom_Ptr src, Chrom_Ptr dst)
 {
-   Gene_Ptr gene;
+   int      *ev_state, ev_len;
+   CH_Slab_Ptr slab;
 
    /*--- Error check ---*/
    if(!CH_valid(src)) UT_error("CH_copy: invalid src");
    if(!CH_valid(dst)) UT_error("CH_copy: invalid dst");
 
-   /*--- Resize if necessary ---*/
-   if(dst->length != src->length) CH_resize(dst, src->length);
+   /*--- Nothing to do ---*/
+   if(src == dst) return OK;
 
-   /*--- Save memory pointed to by gene ---*/
-   gene = dst->gene;
-
-   /*--- Copy chrom ---*/
-   memcpy(dst, src, sizeof(Chrom_Type));
+   /*--- Let go of the genes of dst, make those of src shareable ---*/
+   CH_drop(dst);
+   CH_share(src);
 
-   /*--- Restore memory pointed to by gene ---*/
-   dst->gene = gene;
+   /*--- Save memory pointed to by ev_state ---*/
+   ev_state = dst->ev_state;
+   ev_len   = dst->ev_len;
+   slab     = dst->slab;
 
-   /*--- Copy gene ---*/
-   memcpy(dst->gene, src->gene, src->length * sizeof(Gene_Type));
+   /*--- Copy chrom, genes and share included ---*/
+   memcpy(dst, src, sizeof(Chrom_Type));
+   dst->share->refs++;
+
+   /*--- Restore memory pointed to by ev_state ---*/
+   dst->ev_state = ev_state;
+   dst->ev_len   = ev_len;
+   dst->slab     = slab;
+
+   /*--- Copy evaluation state ---*/
+   if(src->ev_valid) {
+      memcpy(CH_ev_state(dst, src->ev_len), src->ev_state, 
+             src->ev_len * sizeof(int));
+      CH_copied += src->ev_len * sizeof(int);
+   }
 }
 
 /*----------------------------------------------------------------------------
@@ -227,6 +776,58 @@ CH_cmp(
          return 0;
 }
 
+/*----------------------------------------------------------------------------
+| Do chromosomes A and B have the same genes?
+----------------------------------------------------------------------------*/
+int CH_equal(
+   Chrom_Ptr a, Chrom_Ptr b)
+{
+   int i;
+
+   if(a->length != b->length) return FALSE;
+
+   /*--- Compare whole words ---*/
+   if(CH_packed(a) && CH_packed(b))
+      return !memcmp(a->bits, b->bits, NUM_WORDS(a->length)*sizeof(Word_Type));
+
+   /*--- Compare gene by gene ---*/
+   for(i = 0; i < a->length; i++)
+      if(CH_gene(a, i) != CH_gene(b, i)) return FALSE;
+
+   return TRUE;
+}
+
+/*----------------------------------------------------------------------------
+| 64 bit hash of the genes
+|
+| NOTE: Each word (or gene) is folded in with the splitmix64 finalizer, so
+|       chroms which differ in a single bit get unrelated hashes.
+----------------------------------------------------------------------------*/
+Word_Type CH_hash(
+   Chrom_Ptr chrom)
+{
+   Word_Type h, w;
+   int       i, n;
+
+   /*--- Hash whole words when packed ---*/
+   n = CH_packed(chrom) ? NUM_WORDS(chrom->length) : chrom->length;
+
+   h = (Word_Type)chrom->length * 0x9E3779B97F4A7C15ULL;
+   for(i = 0; i < n; i++) {
+      if(CH_packed(chrom))
+         w = chrom->bits[i];
+      else
+         memcpy(&w, &chrom->gene[i], sizeof(Word_Type));
+      h ^= w;
+      h += 0x9E3779B97F4A7C15ULL;
+      h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+      h ^= h >> 31;
+   }
+
+   return h;
+}
+
 /*----------------------------------------------------------------------------
 | Print a chromosome
 ----------------------------------------------------------------------------*/
@@ -241,7 +842,7 @@ CH_print(
    printf("==============================================================\n");
    printf("\nChrom: \n");
    for(i=0; i<chrom->length; i++)
-      printf("%G ", chrom->gene[i]);
+      printf("%G ", CH_gene(chrom, i));
    printf("\n\n");
    printf("fitness = %G, ptf = %G, index = %d, idx_min = %d, idx_max = %d\n", 
       chrom->fitness, chrom->ptf, chrom->index, chrom->idx_min, chrom->idx_max);
@@ -285,10 +886,16 @@ CH_verify(
    /*--- Check for invalid permutation ---*/
    if(ga_info->datatype == DT_INT_PERM) {
 
-      /*--- Allocate allele_count vector ---*/
-      allele_count = calloc(chrom->length, sizeof(char));
-      if(allele_count == NULL) 
-         UT_error("CH_verify: cannot alloc allele_count");
+      /*--- Clear allele_count vector, grown only when too short ---*/
+      if(chrom->length > CH_allele_len) {
+         free(CH_allele);
+         CH_allele = malloc(chrom->length * sizeof(char));
+         if(CH_allele == NULL) 
+            UT_error("CH_verify: cannot alloc allele_count");
+         CH_allele_len = chrom->length;
+      }
+      allele_count = CH_allele;
+      memset(allele_count, 0, chrom->length * sizeof(char));
    
       /*--- Check each gene in the chromosome ---*/
       for(i=0; i<chrom->length; i++) {
@@ -308,41 +915,138 @@ CH_verify(
             UT_error(err_str);
          }
       }
-      free(allele_count);
    }
+
+   ga_info->tot_verify++;
+   return OK;
 }
-/*============================================================================
-| (c) Copyright Arthur L. Corcoran, 1992, 1993.  All rights reserved.
-| (c) Copyright IA UPM - Group 5, 2020.  All rights reserved.
-|
-| Configuration file and ga_info management
-|
-| Functions:
-|    CF_alloc()    - allocate a ga_info
-|    CF_free()     - deallocate a ga_info
-|    CF_valid()    - is ga_info valid?
-|    CF_reset()    - reset config
-|    CF_report()   - print out current config
-|    CF_read()     - read config file
-|    CF_tokenize() - convert input line to tokens
-|    CF_verify()   - ensure ga_info makes sense
-============================================================================*/
 
 /*----------------------------------------------------------------------------
-| Allocate a GA_Info structure
+| Verify a chrom as often as the validation level asks
+|
+| NOTE: "validation sampled" verifies one of every val_sample chroms handed
+|       in, so a run still catches an operator that keeps breaking chroms
+|       at a fraction of the cost.  Chroms not verified are counted too.
 ----------------------------------------------------------------------------*/
-GA_Info_Ptr CF_alloc() 
+int CH_check(
+   GA_Info_Ptr ga_info,
+   Chrom_Ptr   chrom)
 {
-   GA_Info_Ptr ga_info;
-
-   /*--- Allocate memory for a ga_info ---*/
-   ga_info = (GA_Info_Ptr)calloc(1, sizeof(GA_Info_Type));
-   if(ga_info == NULL) UT_error("CF_alloc: alloc failed");
+   switch(ga_info->validation) {
+      case VA_NONE:
+         break;
 
-   /*--- Ensure these are NULL ---*/
-   ga_info->old_pool = NULL;
-   ga_info->new_pool = NULL;
-   ga_info->best     = NULL;
+      case VA_SAMPLED:
+         if((ga_info->tot_verify + ga_info->tot_unverified) % 
+            ga_info->val_sample == 0) 
+            return CH_verify(ga_info, chrom);
+         break;
+
+      default:
+         return CH_verify(ga_info, chrom);
+   }
+
+   ga_info->tot_unverified++;
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Record a changed locus
+|
+| NOTE: Operators which change a few genes report them here so the chrom
+|       can be evaluated incrementally.  When too many loci change, the
+|       whole chrom is considered changed (num_changed = -1).  A chrom
+|       whose fitness is valid and with no changed loci is not evaluated
+|       again (see CH_dirty()).
+----------------------------------------------------------------------------*/
+int CH_changed(
+   Chrom_Ptr chrom,
+   int       locus)
+{
+   /*--- Everything already changed ---*/
+   if(chrom->num_changed < 0) return OK;
+
+   /*--- Too many changes to remember ---*/
+   if(chrom->num_changed >= CH_MAX_CHANGED) {
+      chrom->num_changed = -1;
+      return OK;
+   }
+
+   chrom->changed[chrom->num_changed++] = locus;
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Get room for len ints of evaluation state
+----------------------------------------------------------------------------*/
+int *CH_ev_state(
+   Chrom_Ptr chrom,
+   int       len)
+{
+   /*--- Reallocate memory for evaluation state ---*/
+   if(chrom->ev_len != len) {
+      chrom->ev_state = (int *)realloc(chrom->ev_state, len * sizeof(int));
+      if(chrom->ev_state == NULL) UT_error("CH_ev_state: realloc failed");
+      chrom->ev_len = len;
+   }
+
+   return chrom->ev_state;
+}
+
+/*----------------------------------------------------------------------------
+| Random packed genes, a word at a time
+----------------------------------------------------------------------------*/
+int CH_rand_bits(
+   Chrom_Ptr chrom,
+   Rand_Ptr  rng)
+{
+   int nwords;
+
+   /*--- Error check ---*/
+   if(!CH_packed(chrom)) UT_error("CH_rand_bits: chrom is not packed");
+   CH_own(chrom, FALSE);
+
+   nwords = NUM_WORDS(chrom->length);
+   RN_bits(rng, chrom->bits, nwords);
+
+   /*--- Keep unused bits of the last word clear ---*/
+   if(chrom->length % WORD_BITS)
+      chrom->bits[nwords-1] &= ((Word_Type)1 << (chrom->length % WORD_BITS)) - 1;
+
+   return OK;
+}
+/*============================================================================
+| (c) Copyright Arthur L. Corcoran, 1992, 1993.  All rights reserved.
+| (c) Copyright IA UPM - Group 5, 2020.  All rights reserved.
+|
+| Configuration file and ga_info management
+|
+| Functions:
+|    CF_alloc()    - allocate a ga_info
+|    CF_free()     - deallocate a ga_info
+|    CF_valid()    - is ga_info valid?
+|    CF_reset()    - reset config
+|    CF_report()   - print out current config
+|    CF_read()     - read config file
+|    CF_tokenize() - convert input line to tokens
+|    CF_verify()   - ensure ga_info makes sense
+============================================================================*/
+
+/*----------------------------------------------------------------------------
+| Allocate a GA_Info structure
+----------------------------------------------------------------------------*/
+GA_Info_Ptr CF_alloc() 
+{
+   GA_Info_Ptr ga_info;
+
+   /*--- Allocate memory for a ga_info ---*/
+   ga_info = (GA_Info_Ptr)calloc(1, sizeof(GA_Info_Type));
+   if(ga_info == NULL) UT_error("CF_alloc: alloc failed");
+
+   /*--- Ensure these are NULL ---*/
+   ga_info->old_pool = NULL;
+   ga_info->new_pool = NULL;
+   ga_info->best     = NULL;
 
    /*--- Put in a magic cookie ---*/
    ga_info->magic_cookie = CF_cookie;
@@ -371,6 +1075,12 @@ CF_free(
    if(ga_info->best != NULL) CH_free(ga_info->best);
    ga_info->best = NULL;
 
+   /*--- Free spare genes ---*/
+   CH_spare_free();
+
+   /*--- Stop evaluation threads and free batch scratch, if any ---*/
+   EV_stop(ga_info);
+
    /*--- Put in a NULL cookie ---*/
    ga_info->magic_cookie = NL_cookie;
 
@@ -415,6 +1125,7 @@ CF_reset(
    ga_info->iter            = -1;
    ga_info->max_iter        = -1;
    ga_info->bias            = 1.8;
+   ga_info->tn_size         = 2;
    ga_info->gap             = 0.0;
    ga_info->x_rate          = 1.0;
    ga_info->mu_rate         = 0.0;
@@ -423,6 +1134,12 @@ CF_reset(
    ga_info->elitist         = TRUE;
    ga_info->converged       = FALSE;
    ga_info->use_convergence = TRUE;
+   ga_info->use_delta       = FALSE;
+   ga_info->ev_threads      = 1;
+   ga_info->cache_size      = 0;
+   ga_info->huge_pages      = FALSE;
+   ga_info->validation      = VA_FULL;
+   ga_info->val_sample      = 16;
 
    /*--- Default operators ---*/
    SE_select(ga_info, "roulette");
@@ -430,7 +1147,13 @@ CF_reset(
    MU_select(ga_info, "swap");
    RE_select(ga_info, "append");
    GA_select(ga_info, "generational");
+   LS_select(ga_info, "none");
    ga_info->EV_fun = NULL;
+   ga_info->DV_fun = NULL;
+   ga_info->ls_rate = 1.0;
+   ga_info->ls_iter = 50;
+   ga_info->gr_order = GR_ORDER_NONE;
+   ga_info->gr_prune = 0;
 
    /*--- Default report parameters ---*/
    ga_info->rp_type      = RP_SHORT;
@@ -478,6 +1201,7 @@ CF_report(
       case DT_INT:      fprintf(fid,"Integer\n"); break;
       case DT_INT_PERM: fprintf(fid,"Integer Permutation\n"); break;
       case DT_REAL:     fprintf(fid,"Real\n"); break;
+      case DT_PACKED_BIT: fprintf(fid,"Packed Bit\n"); break;
       default:          fprintf(fid,"Unspecified\n"); break;
    }
    fprintf(fid,"   Init Pool Entered : ");
@@ -512,6 +1236,8 @@ CF_report(
    fprintf(fid,"   Elitism           : %s\n", 
       ga_info->elitist ? "Yes" : "No");
    fprintf(fid,"   Scale Factor      : %G\n", ga_info->scale_factor);
+   if(ga_info->huge_pages)
+      fprintf(fid,"   Huge Pages        : Yes\n");
 
    /*--- Functions ---*/
    fprintf(fid,"\n");
@@ -520,6 +1246,7 @@ CF_report(
       GA_name(ga_info), ga_info->gap);
    fprintf(fid,"   Selection   : %s ", sptr = SE_name(ga_info));
    if(!strcmp(sptr,"rank_biased")) fprintf(fid,"(Bias = %G)", ga_info->bias);
+   if(!strcmp(sptr,"tournament")) fprintf(fid,"(Size = %d)", ga_info->tn_size);
    fprintf(fid,"\n");
    fprintf(fid,"   Crossover   : %s (Rate = %G)\n", 
       X_name(ga_info), ga_info->x_rate);
@@ -527,6 +1254,26 @@ CF_report(
       fprintf(fid,"   Mutation    : %s (Rate = %G)\n", 
          MU_name(ga_info), ga_info->mu_rate);
    fprintf(fid,"   Replacement : %s\n", RE_name(ga_info));
+   if(ga_info->LS_fun != NULL)
+      fprintf(fid,"   Local Search: %s (Rate = %G, Iter = %d)\n", 
+         LS_name(ga_info), ga_info->ls_rate, ga_info->ls_iter);
+   fprintf(fid,"   Evaluation  : %s (Threads = %d, Cache = %d)\n", 
+      ga_info->use_delta ? "Delta" : "Full", ga_info->ev_threads,
+      ga_info->cache_size);
+   if(ga_info->validation == VA_SAMPLED)
+      fprintf(fid,"   Validation  : sampled (1 in %d)\n", ga_info->val_sample);
+   else if(ga_info->validation == VA_NONE)
+      fprintf(fid,"   Validation  : none\n");
+   if(ga_info->gr_order != GR_ORDER_NONE || ga_info->gr_prune != 0) {
+      fprintf(fid,"   Preprocess  : %s ", 
+         ga_info->gr_order == GR_ORDER_DEGREE ? "degree" :
+         ga_info->gr_order == GR_ORDER_DEGENERACY ? "degeneracy" : "none");
+      if(ga_info->gr_prune == GR_PRUNE_GREEDY)
+         fprintf(fid,"(Prune = greedy)");
+      else if(ga_info->gr_prune > 0)
+         fprintf(fid,"(Prune = %d)", ga_info->gr_prune);
+      fprintf(fid,"\n");
+   }
 
    /*--- Reports ---*/
    if(ga_info->rp_type != RP_NONE) {
@@ -618,6 +1365,8 @@ CF_read(
                ga_info->datatype = DT_INT_PERM;
             else if(numtok >= 2 && !strcmp(token[1], "real")) 
                ga_info->datatype = DT_REAL;
+            else if(numtok >= 2 && !strcmp(token[1], "packed_bit")) 
+               ga_info->datatype = DT_PACKED_BIT;
             else
                UT_warn("CF_read: Invalid datatype response");
          } else
@@ -632,6 +1381,18 @@ CF_read(
                ga_info->elitist = FALSE;
             else
                UT_warn("CF_read: Invalid elitism response");
+         } else if(!strcmp(token[0], "evaluation")) {
+            if(numtok >= 2 && !strcmp(token[1], "full"))
+               ga_info->use_delta = FALSE;
+            else if(numtok >= 2 && !strcmp(token[1], "delta"))
+               ga_info->use_delta = TRUE;
+            else
+               UT_warn("CF_read: Invalid evaluation response");
+         } else if(!strcmp(token[0], "eval_threads")) {
+            if(numtok >= 2)
+               sscanf(token[1], "%d", &ga_info->ev_threads);
+            else
+               UT_warn("CF_read: Invalid eval_threads response");
          } else
             UT_warn("CF_read: Unknown config command");
          break;
@@ -642,6 +1403,11 @@ CF_read(
                sscanf(token[1], "%d", &ga_info->function_index);
             else
                UT_warn("CF_read: Invalid function_index response");
+         } else if(!strcmp(token[0], "fitness_cache")) {
+            if(numtok >= 2)
+               sscanf(token[1], "%d", &ga_info->cache_size);
+            else
+               UT_warn("CF_read: Invalid fitness_cache response");
          } else
             UT_warn("CF_read: Unknown config command");
          break;
@@ -670,6 +1436,18 @@ CF_read(
             UT_warn("CF_read: Unknown config command");
          break;
 
+      case 'h': 
+         if(!strcmp(token[0], "huge_pages")) {
+            if(numtok >= 2 && !strcmp(token[1], "true"))
+               ga_info->huge_pages = TRUE;
+            else if(numtok >= 2 && !strcmp(token[1], "false"))
+               ga_info->huge_pages = FALSE;
+            else
+               UT_warn("CF_read: Invalid huge_pages response");
+         } else
+            UT_warn("CF_read: Unknown config command");
+         break;
+
       case 'i': 
          if(!strcmp(token[0], "initpool")) {
             if(numtok >= 2 && !strcmp(token[1], "random")) 
@@ -687,6 +1465,26 @@ CF_read(
             UT_warn("CF_read: Unknown config command");
          break;
 
+      case 'l': 
+         if(!strcmp(token[0], "local_search")) {
+            if(numtok >= 2) 
+               LS_select(ga_info, token[1]);
+            else
+               UT_warn("CF_read: Invalid local_search response");
+         } else if(!strcmp(token[0], "ls_rate")) {
+            if(numtok >= 2)
+               sscanf(token[1], "%f", &ga_info->ls_rate);
+            else
+               UT_warn("CF_read: Invalid ls_rate response");
+         } else if(!strcmp(token[0], "ls_iter")) {
+            if(numtok >= 2)
+               sscanf(token[1], "%d", &ga_info->ls_iter);
+            else
+               UT_warn("CF_read: Invalid ls_iter response");
+         } else
+            UT_warn("CF_read: Unknown config command");
+         break;
+
       case 'm': 
          if(!strcmp(token[0], "mutation")) {
             if(numtok >= 2) 
@@ -720,6 +1518,24 @@ CF_read(
                sscanf(token[1], "%d", &ga_info->pool_size);
             else
                UT_warn("CF_read: Invalid pool_size response");
+         } else if(!strcmp(token[0], "preprocess")) {
+            if(numtok >= 2 && !strcmp(token[1], "none"))
+               ga_info->gr_order = GR_ORDER_NONE;
+            else if(numtok >= 2 && !strcmp(token[1], "degree"))
+               ga_info->gr_order = GR_ORDER_DEGREE;
+            else if(numtok >= 2 && !strcmp(token[1], "degeneracy"))
+               ga_info->gr_order = GR_ORDER_DEGENERACY;
+            else
+               UT_warn("CF_read: Invalid preprocess response");
+         } else if(!strcmp(token[0], "prune")) {
+            if(numtok >= 2 && !strcmp(token[1], "none"))
+               ga_info->gr_prune = 0;
+            else if(numtok >= 2 && !strcmp(token[1], "greedy"))
+               ga_info->gr_prune = GR_PRUNE_GREEDY;
+            else if(numtok >= 2)
+               sscanf(token[1], "%d", &ga_info->gr_prune);
+            else
+               UT_warn("CF_read: Invalid prune response");
          } else
             UT_warn("CF_read: Unknown config command");
          break;
@@ -798,6 +1614,16 @@ CF_read(
             UT_warn("CF_read: Unknown config command");
          break;
 
+      case 't': 
+         if(!strcmp(token[0], "tournament_size")) {
+            if(numtok >= 2 && sscanf(token[1], "%d", &ga_info->tn_size) == 1)
+               ;
+            else
+               UT_warn("CF_read: Invalid tournament_size response");
+         } else
+            UT_warn("CF_read: Unknown config command");
+         break;
+
       case 'u': 
          if(!strcmp(token[0], "user_data")) {
             if(numtok >= 2)
@@ -808,6 +1634,25 @@ CF_read(
             UT_warn("CF_read: Unknown config command");
          break;
 
+      case 'v': 
+         if(!strcmp(token[0], "validation")) {
+            if(numtok >= 2 && !strcmp(token[1], "full"))
+               ga_info->validation = VA_FULL;
+            else if(numtok >= 2 && !strcmp(token[1], "sampled"))
+               ga_info->validation = VA_SAMPLED;
+            else if(numtok >= 2 && !strcmp(token[1], "none"))
+               ga_info->validation = VA_NONE;
+            else
+               UT_warn("CF_read: Invalid validation response");
+         } else if(!strcmp(token[0], "val_sample")) {
+            if(numtok >= 2 && sscanf(token[1], "%d", &ga_info->val_sample) == 1)
+               ;
+            else
+               UT_warn("CF_read: Invalid val_sample response");
+         } else
+            UT_warn("CF_read: Unknown config command");
+         break;
+
       case 'x': 
          if(!strcmp(token[0], "x_rate")) {
             if(numtok >= 2 && sscanf(token[1], "%f", &ga_info->x_rate) == 1)
@@ -873,10 +1718,23 @@ CF_verify(
       case DT_INT:
       case DT_INT_PERM:
       case DT_REAL:
+      case DT_PACKED_BIT:
          break;
       default: UT_error("CF_verify: Invalid datatype");
    }
 
+   /*--- Packed bits are only generated and handled by some operators ---*/
+   if(ga_info->datatype == DT_PACKED_BIT) {
+      if(ga_info->ip_flag != IP_RANDOM && ga_info->ip_flag != IP_RANDOM01 &&
+         ga_info->ip_flag != IP_NONE)
+         UT_error("CF_verify: initpool not supported for packed_bit");
+      if(ga_info->X_fun != X_simple && ga_info->X_fun != X_uniform)
+         UT_error("CF_verify: crossover not supported for packed_bit");
+      if(ga_info->MU_fun != NULL && ga_info->MU_fun != MU_simple_invert &&
+         ga_info->MU_fun != MU_simple_random)
+         UT_error("CF_verify: mutation not supported for packed_bit");
+   }
+
    switch(ga_info->ip_flag) {
       case IP_FROM_FILE:
          if(ga_info->ip_data[0] == '\0')
@@ -900,6 +1758,13 @@ CF_verify(
    if(ga_info->SE_fun == NULL)
       UT_error("CF_verify: no selection function specified");
 
+   if(ga_info->tn_size < 1)
+      UT_error("CF_verify: invalid tournament size");
+
+   if(ga_info->SE_fun == SE_rank_biased && 
+      (ga_info->bias < 1.0 || ga_info->bias > 2.0))
+      UT_error("CF_verify: invalid bias");
+
    if(ga_info->X_fun == NULL)
       UT_error("CF_verify: no crossover function specified");
 
@@ -918,6 +1783,38 @@ CF_verify(
    if(ga_info->EV_fun == NULL)
       UT_error("CF_verify: no evaluation function specified");
 
+   if(ga_info->use_delta && ga_info->DV_fun == NULL)
+      UT_error("CF_verify: no delta evaluation function specified");
+
+   if(ga_info->ev_threads < 1)
+      UT_error("CF_verify: invalid number of evaluation threads");
+
+   if(ga_info->cache_size < 0)
+      UT_error("CF_verify: invalid fitness cache size");
+
+   if(ga_info->val_sample < 1)
+      UT_error("CF_verify: invalid validation sample");
+
+   if(ga_info->ls_rate < 0.0 || ga_info->ls_rate > 1.0)
+      UT_error("CF_verify: invalid local search rate");
+
+   if(ga_info->ls_iter < 0)
+      UT_error("CF_verify: invalid local search iterations");
+
+   if(ga_info->gr_order < GR_ORDER_NONE || 
+      ga_info->gr_order > GR_ORDER_DEGENERACY)
+      UT_error("CF_verify: invalid graph preprocessing");
+
+   if(ga_info->gr_prune < GR_PRUNE_GREEDY)
+      UT_error("CF_verify: invalid prune clique size");
+
+   if(ga_info->LS_fun == LS_clique) {
+      if(!GR_valid(ga_info->graph))
+         UT_error("CF_verify: clique local search needs ga_info->graph");
+      if(ga_info->datatype != DT_BIT && ga_info->datatype != DT_PACKED_BIT)
+         UT_error("CF_verify: clique local search needs bit strings");
+   }
+
    if(ga_info->GA_fun == NULL)
       UT_error("CF_verify: no ga function specified");
 
@@ -976,6 +1873,8 @@ CF_verify(
 |    X_gen_4_xp()  - generate four sorted, random crossover points
 |    X_init_kids() - reset children for crossover
 |    X_map()       - find allele in a chromosome
+|    X_check_packed() - ensure parents and children have packed genes
+|    X_mix_word()  - mix a word of packed genes into the children
 |
 | NOTE: Crossover points should always be thought of as "inclusive"
 ============================================================================*/
@@ -1039,11 +1938,8 @@ X_fun(
    Chrom_Ptr   parent_1,Chrom_Ptr parent_2,
    Chrom_Ptr   child_1,Chrom_Ptr child_2)
 {
-   /*--- Init children ---*/
-   X_init_kids(parent_1, parent_2, child_1, child_2);
-
-   /*--- Clone instead of crossover ---*/
-   if(ga_info->x_rate < 1.0 && RAND_FRAC() > ga_info->x_rate) {
+   /*--- Clone instead of crossover, the children share the parents' genes ---*/
+   if(ga_info->x_rate < 1.0 && RAND_FRAC(&ga_info->rng) > ga_info->x_rate) {
       CH_copy(parent_1, child_1);
       CH_copy(parent_2, child_2);
       child_1->parent_1 = parent_1->index;
@@ -1053,6 +1949,10 @@ X_fun(
       return OK;
    }
 
+   /*--- Init children, only a user operator may rely on zeroed genes ---*/
+   X_init_kids(parent_1, parent_2, child_1, child_2, 
+               ga_info->X_fun == X_table[0].fun);
+
    /*--- No crossover function ---*/
    if(ga_info->X_fun == NULL) 
       return GA_ERROR;
@@ -1078,6 +1978,7 @@ X_simple(
 {
    unsigned i, xp;
    Gene_Type tmp;
+   Word_Type mask;
 
    /*--- Make sure datatype is compatible ---*/
    if(ga_info->datatype == DT_INT_PERM)
@@ -1088,10 +1989,25 @@ X_simple(
       UT_error("crossover: heterozygous parents");
 
    /*--- Random crossover point ---*/
-   X_gen_xp(0, parent_1->length-1, &xp);
+   X_gen_xp(ga_info, 0, parent_1->length-1, &xp);
    child_1->xp1 = xp;
    child_2->xp1 = xp;
 
+   /*--- Packed bits: whole words, masked at the crossover point ---*/
+   if(CH_packed(parent_1)) {
+      X_check_packed(parent_1, parent_2, child_1, child_2);
+      for(i = 0; i < NUM_WORDS(parent_1->length); i++) {
+         if((i+1) * WORD_BITS <= xp+1)
+            mask = ~(Word_Type)0;
+         else if(i * WORD_BITS > xp)
+            mask = 0;
+         else
+            mask = ((Word_Type)1 << ((xp+1) % WORD_BITS)) - 1;
+         X_mix_word(parent_1, parent_2, child_1, child_2, i, mask);
+      }
+      return OK;
+   }
+
    /*--- Half is same as parent ---*/
    for(i = 0; i <= xp; i++) {
       child_1->gene[i] = parent_1->gene[i];
@@ -1117,6 +2033,7 @@ X_uniform(GA_Info_Ptr ga_info,
    Chrom_Ptr  child_1,Chrom_Ptr child_2)
 {
    unsigned i;
+   Word_Type mask[NUM_WORDS(parent_1->length) + 1];
 
    /*--- Make sure datatype is compatible ---*/
    if(ga_info->datatype == DT_INT_PERM)
@@ -1126,8 +2043,19 @@ X_uniform(GA_Info_Ptr ga_info,
    if(parent_1->length != parent_2->length)
       UT_error("crossover: heterozygous parents");
 
+   /*--- One random mask bit per gene, drawn in bulk ---*/
+   RN_bits(&ga_info->rng, mask, NUM_WORDS(parent_1->length));
+
+   /*--- Packed bits: mix a word at a time ---*/
+   if(CH_packed(parent_1)) {
+      X_check_packed(parent_1, parent_2, child_1, child_2);
+      for(i = 0; i < NUM_WORDS(parent_1->length); i++)
+         X_mix_word(parent_1, parent_2, child_1, child_2, i, mask[i]);
+      return OK;
+   }
+
    for(i = 0; i < parent_1->length; i++) {
-      if(RAND_BIT()) {
+      if(BIT_TEST(mask, i)) {
          child_1->gene[i] = parent_1->gene[i];
          child_2->gene[i] = parent_2->gene[i];
       } else {
@@ -1169,7 +2097,7 @@ X_order1(GA_Info_Ptr ga_info,
       UT_error("crossover: heterozygous parents");
 
    /*--- Select two sorted crossover points ---*/
-   X_gen_2_xp(FALSE, 0, parent_1->length, &xp1, &xp2);
+   X_gen_2_xp(ga_info, FALSE, 0, parent_1->length, &xp1, &xp2);
    child_1->xp1 = child_2->xp1 = xp1;
    child_1->xp2 = child_2->xp2 = xp2;
 
@@ -1232,7 +2160,7 @@ X_order2(GA_Info_Ptr ga_info,
       UT_error("crossover: heterozygous parents");
 
    /*--- Select four sorted crossover points ---*/
-   X_gen_4_xp(TRUE, 0, parent_1->length, &xp1, &xp2, &xp3, &xp4);
+   X_gen_4_xp(ga_info, TRUE, 0, parent_1->length, &xp1, &xp2, &xp3, &xp4);
    child_1->xp1 = xp1; child_1->xp2 = xp2;
    child_2->xp1 = xp3; child_2->xp2 = xp4;
 
@@ -1303,7 +2231,7 @@ X_pos(GA_Info_Ptr ga_info,
       UT_error("crossover: heterozygous parents");
 
    /*--- Select four sorted crossover points ---*/
-   X_gen_4_xp(FALSE, 0, parent_1->length, &xp1, &xp2, &xp3, &xp4);
+   X_gen_4_xp(ga_info, FALSE, 0, parent_1->length, &xp1, &xp2, &xp3, &xp4);
    child_1->xp1 = xp1; child_1->xp2 = xp2;
    child_2->xp1 = xp3; child_2->xp2 = xp4;
 
@@ -1379,7 +2307,7 @@ X_cycle(GA_Info_Ptr ga_info,
       UT_error("crossover: heterozygous parents");
 
    /*--- Select crossover point ---*/
-   X_gen_xp(0, parent_1->length, &xp);
+   X_gen_xp(ga_info, 0, parent_1->length, &xp);
    child_1->xp1 = xp;
    child_2->xp1 = xp;
 
@@ -1436,7 +2364,7 @@ X_pmx(GA_Info_Ptr ga_info,
       UT_error("crossover: heterozygous parents");
 
    /*--- Select two sorted crossover points ---*/
-   X_gen_2_xp(FALSE, 0, parent_1->length, &xp1, &xp2);
+   X_gen_2_xp(ga_info, FALSE, 0, parent_1->length, &xp1, &xp2);
    child_1->xp1 = child_2->xp1 = xp1; 
    child_1->xp2 = child_2->xp2 = xp2;
 
@@ -1492,6 +2420,7 @@ X_uox(GA_Info_Ptr ga_info,
    int length;
    static int  m1_length, m2_length;
    static char *m1 = NULL, *m2 = NULL;
+   Word_Type mask[NUM_WORDS(parent_1->length) + 1];
 
    /*--- Make sure datatype is compatible ---*/
    if(ga_info->datatype != DT_INT_PERM)
@@ -1527,9 +2456,10 @@ X_uox(GA_Info_Ptr ga_info,
       }
    }
 
-   /*--- Random mask ---*/
+   /*--- Random mask, drawn in bulk ---*/
+   RN_bits(&ga_info->rng, mask, NUM_WORDS(parent_1->length));
    for(i = 0; i < parent_1->length; i++) {
-      m1[i] = m2[i] = (RAND_BIT() ? 1 : 0);
+      m1[i] = m2[i] = BIT_TEST(mask, i);
    }
 
    /*--- Place alleles from mask ---*/
@@ -1613,8 +2543,8 @@ X_asex(GA_Info_Ptr ga_info,
       UT_error("X_asex: bad data type");
 
    /*--- Perform asexual crossover ---*/
-   X_do_asex(parent_1, child_1);
-   X_do_asex(parent_2, child_2);
+   X_do_asex(ga_info, parent_1, child_1);
+   X_do_asex(ga_info, parent_2, child_2);
 
    return OK;
 }
@@ -1625,6 +2555,7 @@ X_asex(GA_Info_Ptr ga_info,
 | Perform asexual crossover for X_asex()
 ----------------------------------------------------------------------------*/
 X_do_asex(
+   GA_Info_Ptr ga_info,
    Chrom_Ptr  parent,
    Chrom_Ptr  child)
 {
@@ -1640,7 +2571,7 @@ X_do_asex(
    if(parent->idx_min >= parent->length-1) return OK;
 
    /*--- Select two sorted crossover points ---*/
-   X_gen_2_xp(TRUE, parent->idx_min, parent->length, &xp1, &xp2);
+   X_gen_2_xp(ga_info, TRUE, parent->idx_min, parent->length, &xp1, &xp2);
    child->xp1 = xp1; 
    child->xp2 = xp2;
 
@@ -1658,24 +2589,25 @@ X_do_asex(
 | Generate crossover point in [idx_min..idx_max-1]
 ----------------------------------------------------------------------------*/
 X_gen_xp(
+   GA_Info_Ptr ga_info,
    int idx_min,int idx_max,int *xp)
 {
-   *xp = RAND_DOM(idx_min, idx_max - 1);
+   *xp = RAND_DOM(&ga_info->rng, idx_min, idx_max - 1);
 }
 
 /*----------------------------------------------------------------------------
 | Generate two sorted crossover points
 ----------------------------------------------------------------------------*/
-X_gen_2_xp(int unique,int  idx_min,int  idx_max,int  *xp1,int  *xp2)  
+X_gen_2_xp(GA_Info_Ptr ga_info,int unique,int  idx_min,int  idx_max,int  *xp1,int  *xp2)  
 {
    /*--- Generate two points ---*/
-   X_gen_xp(idx_min, idx_max, xp1);
-   X_gen_xp(idx_min, idx_max, xp2);
+   X_gen_xp(ga_info, idx_min, idx_max, xp1);
+   X_gen_xp(ga_info, idx_min, idx_max, xp2);
 
    /*--- Make sure unique if specified ---*/
    if(unique) {
       while(*xp2 == *xp1) 
-         X_gen_xp(idx_min, idx_max, xp2);
+         X_gen_xp(ga_info, idx_min, idx_max, xp2);
    }
 
    /*--- Make sure they are sorted ---*/
@@ -1686,24 +2618,24 @@ X_gen_2_xp(int unique,int  idx_min,int  idx_max,int  *xp1,int  *xp2)
 /*----------------------------------------------------------------------------
 | Generate four sorted crossover points
 ----------------------------------------------------------------------------*/
-X_gen_4_xp(int unique,int idx_min,int idx_max,int *xp1,int *xp2,int *xp3,int *xp4)   
+X_gen_4_xp(GA_Info_Ptr ga_info,int unique,int idx_min,int idx_max,int *xp1,int *xp2,int *xp3,int *xp4)   
 {
    /*--- Generate four points ---*/
-   X_gen_xp(idx_min, idx_max, xp1);
-   X_gen_xp(idx_min, idx_max, xp2);
-   X_gen_xp(idx_min, idx_max, xp3);
-   X_gen_xp(idx_min, idx_max, xp4);
+   X_gen_xp(ga_info, idx_min, idx_max, xp1);
+   X_gen_xp(ga_info, idx_min, idx_max, xp2);
+   X_gen_xp(ga_info, idx_min, idx_max, xp3);
+   X_gen_xp(ga_info, idx_min, idx_max, xp4);
 
    /*--- Make sure unique if specified ---*/
    if(unique) {
       while(*xp2 == *xp1) 
-         X_gen_xp(idx_min, idx_max, xp2);
+         X_gen_xp(ga_info, idx_min, idx_max, xp2);
 
       while(*xp3 == *xp1 || *xp3 == *xp2) 
-         X_gen_xp(idx_min, idx_max, xp3);
+         X_gen_xp(ga_info, idx_min, idx_max, xp3);
 
       while(*xp4 == *xp1 || *xp4 == *xp2 || *xp4 == *xp3) 
-         X_gen_xp(idx_min, idx_max, xp4);
+         X_gen_xp(ga_info, idx_min, idx_max, xp4);
    }
 
    /*--- Make sure they are sorted (use "sorting network") ---*/
@@ -1716,10 +2648,14 @@ X_gen_4_xp(int unique,int idx_min,int idx_max,int *xp1,int *xp2,int *xp3,int *xp
 
 /*----------------------------------------------------------------------------
 | Initialize child chromosomes for crossover
+|
+| NOTE: The genes are zeroed only if asked to, every built-in operator and
+|       cloning overwrite all of them
 ----------------------------------------------------------------------------*/
 X_init_kids(
    Chrom_Ptr  parent_1,Chrom_Ptr parent_2,
-   Chrom_Ptr  child_1,Chrom_Ptr child_2)
+   Chrom_Ptr  child_1,Chrom_Ptr child_2,
+   int        zero_genes)
 {
    /*--- Assume for now that parents are homozygous ---*/
    if(parent_1->length <= 0) UT_error("crossover: parent_1->length");
@@ -1727,9 +2663,16 @@ X_init_kids(
    if(child_1 == NULL) UT_error("X_init_kids: null child_1");
    if(child_2 == NULL) UT_error("X_init_kids: null child_2");
 
-   /*--- Initialize the children ---*/
-   CH_reset(child_1);
-   CH_reset(child_2);
+   /*--- Initialize the children, with genes of their own ---*/
+   if(zero_genes) {
+      CH_reset(child_1);
+      CH_reset(child_2);
+   } else {
+      CH_own(child_1, FALSE);
+      CH_own(child_2, FALSE);
+      CH_reset_info(child_1);
+      CH_reset_info(child_2);
+   }
    child_1->parent_1 = parent_1->index;
    child_1->parent_2 = parent_2->index;
    child_2->parent_1 = parent_1->index;
@@ -1758,6 +2701,40 @@ X_map(
    /*--- Not found ---*/
    return -1;
 }
+
+/*----------------------------------------------------------------------------
+| Ensure parents and children all have packed genes
+----------------------------------------------------------------------------*/
+int X_check_packed(
+   Chrom_Ptr  parent_1,Chrom_Ptr parent_2,
+   Chrom_Ptr  child_1,Chrom_Ptr child_2)
+{
+   if(!CH_packed(parent_1) || !CH_packed(parent_2) ||
+      !CH_packed(child_1) || !CH_packed(child_2))
+      UT_error("crossover: packed and unpacked chroms mixed");
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Word i of the children: bits set in mask from the respective parent, 
+| the others from the alternate parent
+----------------------------------------------------------------------------*/
+int X_mix_word(
+   Chrom_Ptr  parent_1,Chrom_Ptr parent_2,
+   Chrom_Ptr  child_1,Chrom_Ptr child_2,
+   int        i,
+   Word_Type  mask)
+{
+   Word_Type w1, w2;
+
+   w1 = parent_1->bits[i];
+   w2 = parent_2->bits[i];
+   child_1->bits[i] = (w1 & mask) | (w2 & ~mask);
+   child_2->bits[i] = (w2 & mask) | (w1 & ~mask);
+
+   return OK;
+}
 /*============================================================================
 | (c) Copyright Arthur L. Corcoran, 1992, 1993.  All rights reserved.
 | (c) Copyright IA UPM - Group 5, 2020.  All rights reserved.
@@ -1917,6 +2894,7 @@ char *FN_name(
 |    GA_trial()      - a single iteration of the inner loop
 |    GA_cum()        - see if children are the cumulative/historical best
 |    GA_gap()        - handle generation gap
+|    GA_picks()      - number of selections left in a generation
 ============================================================================*/
 
 /*============================================================================
@@ -1991,19 +2969,21 @@ GA_reset(
    GA_Info_Ptr ga_info,
    char *cfg_name)
 {
-   int  (*EV_fun)();
+   int  (*EV_fun)(), (*DV_fun)();
 
    /*--- Error check ---*/
    if(!CF_valid(ga_info)) UT_error("GA_reset: invalid ga_info");
 
-   /*--- Save EV_fun() ---*/
+   /*--- Save EV_fun() and DV_fun() ---*/
    EV_fun = ga_info->EV_fun;
+   DV_fun = ga_info->DV_fun;
 
    /*--- Reset ga_info ---*/
    CF_reset(ga_info);
 
-   /*--- Restore EV_fun() ---*/
+   /*--- Restore EV_fun() and DV_fun() ---*/
    ga_info->EV_fun = EV_fun;
+   ga_info->DV_fun = DV_fun;
 
    /*--- Read config file if provided ---*/
    if(cfg_name != NULL && cfg_name[0] != '\0' && cfg_name[0] != '\n')
@@ -2024,11 +3004,36 @@ GA_run(
 
    //printf("seed: %d",ga_info->rand_seed);
    /*--- Seed random number generator ---*/
-   SEED_RAND(ga_info->rand_seed);
+   SEED_RAND(&ga_info->rng, ga_info->rand_seed);
+
+   /*--- No evaluations yet ---*/
+   ga_info->tot_eval    = 0;
+   ga_info->tot_delta   = 0;
+   ga_info->tot_skip    = 0;
+   ga_info->tot_ls      = 0;
+   ga_info->tot_copy    = 0;
+   ga_info->tot_trial   = 0;
+   CH_copied            = 0;
+   ga_info->tot_verify  = 0;
+   ga_info->tot_unverified = 0;
+   ga_info->cache_hit   = 0;
+   ga_info->cache_miss  = 0;
+   ga_info->cache_evict = 0;
    
    /*--- Run the GA ---*/
    ga_info->GA_fun(ga_info);
 
+   /*--- Stop evaluation threads and drop cache, if any ---*/
+   EV_stop(ga_info);
+   EV_cache_free(ga_info);
+
+   /*--- Free spare genes ---*/
+   CH_spare_free();
+
+   /*--- Free allele counts of CH_verify() ---*/
+   free(CH_allele);
+   CH_allele     = NULL;
+   CH_allele_len = 0;
 }
 
 /*============================================================================
@@ -2056,13 +3061,19 @@ GA_generational(
       /*--- Setup for new set of trials ---*/
       GA_init_trial(ga_info);
 
+      /*--- Parents of the whole generation, if selection is by batch ---*/
+      SE_batch(ga_info, ga_info->old_pool, GA_picks(ga_info));
+
       /*--- Handle generation gap ---*/
       GA_gap(ga_info);
 
       /*--- Inner loop is for each reproduction ---*/
-      for( ; ga_info->new_pool->size < ga_info->old_pool->size; ) {
-         GA_trial(ga_info);
-      }
+      if(ga_info->ev_threads > 1 && ga_info->RE_fun == RE_append)
+         GA_batch(ga_info);
+      else
+         for( ; ga_info->new_pool->size < ga_info->old_pool->size; ) {
+            GA_trial(ga_info);
+         }
 
       /*--- Print report if appropriate ---*/
       RP_report(ga_info, ga_info->new_pool);
@@ -2102,6 +3113,12 @@ void GA_gen_init(
    old_pool = ga_info->old_pool;
    new_pool = ga_info->new_pool;
 
+   /*--- Chromosome slots of both pools ---*/
+   PL_slab(old_pool, ga_info->chrom_len, ga_info->datatype, 
+           ga_info->huge_pages);
+   PL_slab(new_pool, ga_info->chrom_len, ga_info->datatype, 
+           ga_info->huge_pages);
+
    /*--- Minimize or maximize? ---*/
    old_pool->minimize = new_pool->minimize = ga_info->minimize;
  
@@ -2120,10 +3137,14 @@ void GA_gen_init(
          PL_append(old_pool, old_pool->chrom[old_pool->max_index], TRUE);
    }
    new_pool->size = 0;
+   PL_touch(new_pool);
+
+   /*--- Scratch for evaluating a generation as one batch ---*/
+   EV_room(ga_info, old_pool->size + 2);
 
    /*--- Make sure best is allocated ---*/
    if(!CH_valid(ga_info->best)) 
-      ga_info->best = CH_alloc(ga_info->chrom_len);
+      ga_info->best = CH_alloc_type(ga_info->chrom_len, ga_info->datatype);
     
    /*--- Save best member of initial pool ---*/
    if(ga_info->minimize)
@@ -2140,8 +3161,8 @@ void GA_gen_init(
    RP_report(ga_info, old_pool);
 
    /*--- Allocate genes for children ---*/
-   child1 = CH_alloc(ga_info->chrom_len);
-   child2 = CH_alloc(ga_info->chrom_len);
+   child1 = CH_alloc_type(ga_info->chrom_len, ga_info->datatype);
+   child2 = CH_alloc_type(ga_info->chrom_len, ga_info->datatype);
 }
  
 /*----------------------------------------------------------------------------
@@ -2153,6 +3174,8 @@ GA_init_trial(GA_Info_Ptr ga_info)
 
    /*--- Cleanup the new pool ---*/
    ga_info->new_pool->size = 0;
+   PL_touch(ga_info->new_pool);
+   ga_info->trial = 0;
  
    /*--- Reset number of mutations ---*/
    ga_info->num_mut = 0;
@@ -2201,6 +3224,7 @@ GA_steady_state(
       if(ga_info->use_convergence && ga_info->converged) break;
  
       /*--- "Inner loop" is a single reproduction ---*/
+      ga_info->trial = 0;
       GA_trial(ga_info);
  
       /*--- Print report if appropriate ---*/
@@ -2241,6 +3265,9 @@ GA_ss_init(
    }
    pool = ga_info->old_pool;
 
+   /*--- Chromosome slots of the pool ---*/
+   PL_slab(pool, ga_info->chrom_len, ga_info->datatype, ga_info->huge_pages);
+
    /*--- Minimize or maximize ---*/
    pool->minimize = ga_info->minimize;
 
@@ -2252,7 +3279,7 @@ GA_ss_init(
 
    /*--- Make sure best is allocated ---*/
    if(!CH_valid(ga_info->best)) 
-      ga_info->best = CH_alloc(ga_info->chrom_len);
+      ga_info->best = CH_alloc_type(ga_info->chrom_len, ga_info->datatype);
 
    /*--- Save min and max members of initial pool ---*/
    if(ga_info->minimize) 
@@ -2269,8 +3296,8 @@ GA_ss_init(
    RP_report(ga_info, pool);
 
    /*--- Allocate genes for children ---*/
-   child1 = CH_alloc(ga_info->chrom_len);
-   child2 = CH_alloc(ga_info->chrom_len);
+   child1 = CH_alloc_type(ga_info->chrom_len, ga_info->datatype);
+   child2 = CH_alloc_type(ga_info->chrom_len, ga_info->datatype);
 }
 
 /*============================================================================
@@ -2282,16 +3309,20 @@ GA_ss_init(
 void GA_trial(
    GA_Info_Ptr ga_info)
 {
-   Chrom_Ptr parent1, parent2;
+   Chrom_Ptr parent1, parent2, kid1, kid2;
+   int       dirty1, dirty2;
 
+   /*--- Draws of this trial ---*/
+   RN_stream(&ga_info->rng, ga_info->rand_seed, ga_info->iter, 
+             ga_info->trial++);
 
    /*--- Selection ---*/
    parent1 = SE_fun(ga_info, ga_info->old_pool);
    parent2 = SE_fun(ga_info, ga_info->old_pool);
 
    /*--- Validate parents ---*/
-   CH_verify(ga_info, parent1);
-   CH_verify(ga_info, parent2);
+   CH_check(ga_info, parent1);
+   CH_check(ga_info, parent2);
    
    /*--- Crossover ---*/
    X_fun(ga_info, parent1, parent2, child1, child2);
@@ -2299,25 +3330,119 @@ void GA_trial(
    /*--- Mutation ---*/
    MU_fun(ga_info, child1);
    MU_fun(ga_info, child2);
+
+   /*--- Local search ---*/
+   LS_fun(ga_info, child1);
+   LS_fun(ga_info, child2);
    
+   /*--- Unchanged clones need neither evaluation nor validation ---*/
+   dirty1 = CH_dirty(child1);
+   dirty2 = CH_dirty(child2);
+
    /*--- Evaluate children ---*/
-   ga_info->EV_fun(child1);
-   ga_info->EV_fun(child2);
+   EV_fun(ga_info, child1);
+   EV_fun(ga_info, child2);
 
    /*--- Validate children ---*/
-   CH_verify(ga_info, child1);
-   CH_verify(ga_info, child2);
+   if(dirty1) CH_check(ga_info, child1);
+   if(dirty2) CH_check(ga_info, child2);
 
-   /*--- Replacement ---*/
-   RE_fun(ga_info, ga_info->new_pool, parent1, parent2, child1, child2);
+   /*--- Replacement, may hand the children over to the new pool ---*/
+   kid1 = child1;
+   kid2 = child2;
+   RE_move(ga_info, ga_info->new_pool, parent1, parent2, &child1, &child2);
    
    /*--- Best So Far? ---*/
-   GA_cum(ga_info, child1, child2);
+   GA_cum(ga_info, kid1, kid2);
    
    /*--- Update GA system statistics ---*/
+   ga_info->tot_trial++;
+   ga_info->tot_copy = CH_copied;
    PL_stats(ga_info, ga_info->new_pool);
 }
 
+/*----------------------------------------------------------------------------
+| All the trials of a generation, children evaluated as one batch
+|
+| NOTE: Same result as calling GA_trial() until the new pool is full when
+|       replacement is "append": selection only looks at the old pool and
+|       evaluation draws no random numbers, so the children can be bred 
+|       first, then evaluated, then compared with their parents (elitism).
+----------------------------------------------------------------------------*/
+int GA_batch(
+   GA_Info_Ptr ga_info)
+{
+   Chrom_Ptr *parent;
+   Pool_Ptr  pool;
+   int       first, i, k;
+
+   pool  = ga_info->new_pool;
+   first = pool->size;
+
+   /*--- Parents of each pair of children ---*/
+   EV_room(ga_info, ga_info->old_pool->size - first + 2);
+   parent = ga_info->ev_parent;
+
+   /*--- Breed all the children into the new pool ---*/
+   for(k = 0; pool->size < ga_info->old_pool->size; k += 2) {
+
+      /*--- Draws of this trial, as in GA_trial() ---*/
+      RN_stream(&ga_info->rng, ga_info->rand_seed, ga_info->iter, 
+                ga_info->trial++);
+
+      /*--- Selection ---*/
+      parent[k]   = SE_fun(ga_info, ga_info->old_pool);
+      parent[k+1] = SE_fun(ga_info, ga_info->old_pool);
+
+      /*--- Validate parents ---*/
+      CH_check(ga_info, parent[k]);
+      CH_check(ga_info, parent[k+1]);
+
+      /*--- Crossover ---*/
+      X_fun(ga_info, parent[k], parent[k+1], child1, child2);
+
+      /*--- Mutation ---*/
+      MU_fun(ga_info, child1);
+      MU_fun(ga_info, child2);
+
+      /*--- Local search ---*/
+      LS_fun(ga_info, child1);
+      LS_fun(ga_info, child2);
+
+      /*--- Validate children, unless unchanged clones ---*/
+      if(CH_dirty(child1)) CH_check(ga_info, child1);
+      if(CH_dirty(child2)) CH_check(ga_info, child2);
+
+      /*--- Replacement, elitism is left for later: hand the children over ---*/
+      PL_append_move(pool, &child1);
+      PL_append_move(pool, &child2);
+      ga_info->tot_trial++;
+   }
+
+   /*--- Evaluate children ---*/
+   EV_batch(ga_info, pool->chrom + first, pool->size - first);
+
+   for(i = first, k = 0; i + 1 < pool->size; i += 2, k += 2) {
+
+      /*--- Elitism ---*/
+      if(ga_info->elitist)
+         RE_pick_best(ga_info, parent[k], parent[k+1], 
+                      pool->chrom[i], pool->chrom[i+1]);
+
+      /*--- Best So Far? ---*/
+      GA_cum(ga_info, pool->chrom[i], pool->chrom[i+1]);
+   }
+
+   /*--- Fitness of the children changed in place ---*/
+   PL_touch(pool);
+
+   /*--- Update GA system statistics ---*/
+   ga_info->tot_copy = CH_copied;
+   PL_stats(ga_info, pool);
+
+   return OK;
+}
+
 /*============================================================================
 |                               Utility
 ============================================================================*/
@@ -2356,6 +3481,9 @@ GA_gap(
    /*--- How many to copy over ---*/
    num_clones = (int)(ga_info->pool_size * ga_info->gap);
 
+   /*--- Draws of the gap ---*/
+   RN_stream(&ga_info->rng, ga_info->rand_seed, ga_info->iter, RN_GAP);
+
    /*--- Append to new pool ---*/
    for(i=0; 
        i < num_clones && ga_info->new_pool->size < ga_info->old_pool->size;
@@ -2375,54 +3503,576 @@ GA_gap(
 
    return OK;
 }
+
+/*----------------------------------------------------------------------------
+| Number of selections left in a generation: the clones of the gap, then
+| two parents per trial until the new pool is full
+----------------------------------------------------------------------------*/
+int GA_picks(
+   GA_Info_Ptr ga_info)
+{
+   int left, num_clones = 0;
+
+   left = ga_info->old_pool->size - ga_info->new_pool->size;
+   if(left <= 0) return 0;
+
+   /*--- Generation gap ---*/
+   if(ga_info->gap > 0.0) 
+      num_clones = MIN((int)(ga_info->pool_size * ga_info->gap), left);
+
+   /*--- Trials ---*/
+   return num_clones + 2 * ((left - num_clones + 1) / 2);
+}
 /*============================================================================
-| (c) Copyright Arthur L. Corcoran, 1992, 1993.  All rights reserved.
 | (c) Copyright IA UPM - Group 5, 2020.  All rights reserved.
 |
-| Mutation operators 
+| Evaluation
 |
-| Bit String Representations
-|    MU_simple_invert() - random bit inversion based on mutation rate
-|    MU_simple_random() - random bit value based on mutation rate
+| Interface
+|    EV_fun()     - evaluate a chrom, incrementally if possible
+|    EV_batch()   - evaluate a batch of chroms, in parallel if possible
+|    EV_stop()    - stop the evaluation threads, free batch scratch
+|    EV_cache_free() - free the fitness cache
 |
-| Any Representation
-|    MU_swap()          - random element swap based on mutation rate
+| Utility
+|    EV_count()   - update evaluation statistics for a chrom
+|    EV_call()    - call the user's evaluation function
+|    EV_run()     - evaluate a batch of chroms, in parallel if possible
+|    EV_room()    - make room in the scratch of batches
+|    EV_worker()  - evaluation thread
+|    EV_lookup()  - look up the fitness of a chrom in the cache
+|    EV_store()   - store the fitness of a chrom in the cache
+|    EV_entry()   - entry of the cache for a hash
+|    EV_take()    - give a chrom a fitness from the cache
 |
-| Interface
-|    MU_table[]   - used in selection of mutation method
-|    MU_set_fun() - set and select user defined mutation function
-|    MU_select()  - select mutation function by name
-|    MU_name()    - get name of current mutation function
-|    MU_fun()     - setup and perform current mutation operator
+| NOTE: With "evaluation delta" the user's DV_fun() is called instead of
+|       EV_fun().  It receives the chrom with the loci changed since its
+|       last evaluation (num_changed, changed[]) and the state it left in
+|       ev_state.  When num_changed < 0 or ev_valid is FALSE, it must
+|       rebuild its state from scratch.
+|
+| NOTE: With "eval_threads n", n > 1, EV_batch() hands the chroms to n-1
+|       threads plus the caller, so EV_fun() and DV_fun() must be safe to
+|       call on different chroms at the same time.  Each chrom is evaluated
+|       exactly as it would be serially, so results do not depend on n.
+|
+| NOTE: With "fitness_cache n", n > 0, fitnesses are remembered by a 64 bit
+|       hash of the genes in a direct mapped table of n entries (rounded up
+|       to a power of 2).  A chrom found there is not evaluated at all, nor
+|       is a copy of a chrom met earlier in the same batch, so the counts
+|       do not depend on n either.  The evaluation function must depend on
+|       the genes only.
 ============================================================================*/
 
-/*============================================================================
-|                     Mutation interface
-============================================================================*/
-/*----------------------------------------------------------------------------
-| Mutation table
-----------------------------------------------------------------------------*/
-FN_Table_Type MU_table[] = {
-   {  NULL,           NULL             }, /* user defined function */
-   { "simple_invert", MU_simple_invert },
-   { "simple_random", MU_simple_random },
-   { "swap",          MU_swap          },
-   { "float_random",  MU_float_random  },
-   { "float_rnd_pert",MU_float_rnd_pert},
-   { "float_LS",      MU_float_LS      },
-   { "float_gauss_pert",MU_float_gauss_pert},
-   { NULL,            NULL             }
-};
+/*--- Fitness cache ---*/
+typedef struct {
+   Word_Type  hash;                 /* Hash of the genes */
+   double     fitness;              /* Their fitness */
+   int        used;                 /* Is this entry in use? */
+   int        wait;                 /* Miss of EV_batch() it waits for + 1 */
+} EV_Entry_Type, *EV_Entry_Ptr;
+
+typedef struct {
+   int          size;               /* Number of entries, a power of 2 */
+   EV_Entry_Ptr entry;
+} EV_Cache_Type, *EV_Cache_Ptr;
+
+EV_Entry_Ptr EV_entry(GA_Info_Ptr ga_info, Word_Type hash);
+
+#ifndef GA_NO_THREADS
+/*--- Threads shared by all batches of a run ---*/
+typedef struct {
+   pthread_t       *tid;           /* Worker threads */
+   int             nthreads;       /* Number of worker threads */
+   pthread_mutex_t lock;
+   pthread_cond_t  start, done;
+   GA_Info_Ptr     ga_info;        /* Current batch */
+   Chrom_Ptr       *chrom;
+   int             n, next;        /* Batch size, next chrom to evaluate */
+   int             busy;           /* Workers still in this batch */
+   long            round;          /* Batch number */
+   int             quit;           /* Time to exit? */
+} EV_Pool_Type, *EV_Pool_Ptr;
+
+void *EV_worker(void *arg);
+#endif
 
 /*----------------------------------------------------------------------------
-| Select user mutation method
+| Evaluation interface
 ----------------------------------------------------------------------------*/
-MU_set_fun(
-   GA_Info_Ptr  ga_info,
-   char         *fn_name,
-   FN_Ptr       fn_ptr)
+int EV_fun(
+   GA_Info_Ptr ga_info,
+   Chrom_Ptr   chrom)
 {
-   return FN_set_fun(ga_info, MU_table, fn_name, fn_ptr, &ga_info->MU_fun);
+   Word_Type hash;
+
+   /*--- Genes did not change since last evaluation ---*/
+   if(!CH_dirty(chrom)) {
+      ga_info->tot_skip++;
+      return OK;
+   }
+
+   /*--- Seen these genes before? ---*/
+   if(EV_lookup(ga_info, chrom, &hash)) return OK;
+
+   EV_count(ga_info, chrom);
+   EV_call(ga_info, chrom);
+
+   /*--- Remember them ---*/
+   EV_store(ga_info, chrom, hash);
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Update evaluation statistics for a chrom about to be evaluated
+----------------------------------------------------------------------------*/
+int EV_count(
+   GA_Info_Ptr ga_info,
+   Chrom_Ptr   chrom)
+{
+   if(ga_info->use_delta && ga_info->DV_fun != NULL &&
+      chrom->ev_valid && chrom->num_changed >= 0) 
+      ga_info->tot_delta++;
+   ga_info->tot_eval++;
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Call the user's evaluation function
+----------------------------------------------------------------------------*/
+int EV_call(
+   GA_Info_Ptr ga_info,
+   Chrom_Ptr   chrom)
+{
+   /*--- Delta evaluation ---*/
+   if(ga_info->use_delta && ga_info->DV_fun != NULL) {
+      ga_info->DV_fun(chrom);
+      chrom->ev_valid = TRUE;
+
+   /*--- Full evaluation ---*/
+   } else {
+      ga_info->EV_fun(chrom);
+   }
+
+   /*--- Nothing changed since this evaluation ---*/
+   chrom->fit_valid   = TRUE;
+   chrom->num_changed = 0;
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Evaluate a batch of chroms
+----------------------------------------------------------------------------*/
+int EV_batch(
+   GA_Info_Ptr ga_info,
+   Chrom_Ptr   *chrom,
+   int         n)
+{
+   Chrom_Ptr    *miss;
+   Word_Type    *hash;
+   int          *same;
+   EV_Entry_Ptr entry;
+   int          i, m;
+
+   EV_room(ga_info, n + 1);
+   miss = ga_info->ev_miss;
+   hash = ga_info->ev_hash;
+   same = ga_info->ev_same;
+
+   /*--- Only evaluate changed chroms not found in the cache ---*/
+   for(i = m = 0; i < n; i++) {
+      same[i] = -1;
+      if(!CH_dirty(chrom[i]))
+         ga_info->tot_skip++;
+      else if(EV_lookup(ga_info, chrom[i], &hash[m]))
+         ;
+
+      /*--- Same genes as a miss of this batch: a hit, as if serial ---*/
+      else if((entry = EV_entry(ga_info, hash[m])) != NULL && 
+              entry->wait > 0 && entry->hash == hash[m] &&
+              CH_equal(chrom[i], miss[entry->wait - 1])) {
+         ga_info->cache_miss--;
+         ga_info->cache_hit++;
+         same[i] = entry->wait - 1;
+      }
+
+      /*--- Hold the entry for the miss, as EV_store() would after it ---*/
+      else {
+         if(entry != NULL) {
+            if(entry->used && entry->hash != hash[m]) ga_info->cache_evict++;
+            entry->hash = hash[m];
+            entry->used = TRUE;
+            entry->wait = m + 1;
+         }
+         miss[m++] = chrom[i];
+      }
+   }
+   EV_run(ga_info, miss, m);
+
+   /*--- Fill in the entries still held for the misses ---*/
+   for(i = 0; i < m; i++) {
+      entry = EV_entry(ga_info, hash[i]);
+      if(entry != NULL && entry->wait == i + 1) {
+         entry->fitness = miss[i]->fitness;
+         entry->wait    = 0;
+      }
+   }
+
+   /*--- Copies of a miss take its fitness ---*/
+   for(i = 0; i < n; i++)
+      if(same[i] >= 0) EV_take(chrom[i], miss[same[i]]->fitness);
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Make room for batches of n chroms in the scratch of GA_batch() and 
+| EV_batch()
+|
+| NOTE: GA_gen_init() makes room for a whole generation, so batches do not
+|       allocate.  EV_stop() frees the scratch.
+----------------------------------------------------------------------------*/
+int EV_room(
+   GA_Info_Ptr ga_info,
+   int         n)
+{
+   if(n <= ga_info->ev_room) return OK;
+
+   ga_info->ev_parent = (Chrom_Ptr *)realloc(ga_info->ev_parent, 
+                                             n * sizeof(Chrom_Ptr));
+   ga_info->ev_miss   = (Chrom_Ptr *)realloc(ga_info->ev_miss, 
+                                             n * sizeof(Chrom_Ptr));
+   ga_info->ev_hash   = (Word_Type *)realloc(ga_info->ev_hash, 
+                                             n * sizeof(Word_Type));
+   ga_info->ev_same   = (int *)realloc(ga_info->ev_same, n * sizeof(int));
+   if(ga_info->ev_parent == NULL || ga_info->ev_miss == NULL || 
+      ga_info->ev_hash == NULL || ga_info->ev_same == NULL)
+      UT_error("EV_room: alloc failed");
+   ga_info->ev_room = n;
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Evaluate a batch of chroms, in parallel if possible
+----------------------------------------------------------------------------*/
+int EV_run(
+   GA_Info_Ptr ga_info,
+   Chrom_Ptr   *chrom,
+   int         n)
+{
+   int i;
+#ifndef GA_NO_THREADS
+   EV_Pool_Ptr ev_pool;
+#endif
+
+   /*--- Statistics are kept by this thread only ---*/
+   for(i = 0; i < n; i++)
+      EV_count(ga_info, chrom[i]);
+
+#ifndef GA_NO_THREADS
+   if(ga_info->ev_threads > 1 && n > 1) {
+
+      /*--- Start the threads on first use ---*/
+      if(ga_info->ev_pool == NULL) {
+         ev_pool = (EV_Pool_Ptr)calloc(1, sizeof(EV_Pool_Type));
+         if(ev_pool == NULL) UT_error("EV_run: ev_pool alloc failed");
+         ev_pool->nthreads = ga_info->ev_threads - 1;
+         ev_pool->tid = (pthread_t *)calloc(ev_pool->nthreads, 
+                                            sizeof(pthread_t));
+         if(ev_pool->tid == NULL) UT_error("EV_run: tid alloc failed");
+         pthread_mutex_init(&ev_pool->lock, NULL);
+         pthread_cond_init(&ev_pool->start, NULL);
+         pthread_cond_init(&ev_pool->done, NULL);
+         for(i = 0; i < ev_pool->nthreads; i++)
+            if(pthread_create(&ev_pool->tid[i], NULL, EV_worker, ev_pool))
+               UT_error("EV_run: pthread_create failed");
+         ga_info->ev_pool = ev_pool;
+      }
+      ev_pool = (EV_Pool_Ptr)ga_info->ev_pool;
+
+      /*--- Hand out the batch ---*/
+      pthread_mutex_lock(&ev_pool->lock);
+      ev_pool->ga_info = ga_info;
+      ev_pool->chrom   = chrom;
+      ev_pool->n       = n;
+      ev_pool->next    = 0;
+      ev_pool->busy    = ev_pool->nthreads;
+      ev_pool->round++;
+      pthread_cond_broadcast(&ev_pool->start);
+
+      /*--- Take part in it ---*/
+      while(ev_pool->next < n) {
+         i = ev_pool->next++;
+         pthread_mutex_unlock(&ev_pool->lock);
+         EV_call(ga_info, chrom[i]);
+         pthread_mutex_lock(&ev_pool->lock);
+      }
+
+      /*--- Wait for the workers ---*/
+      while(ev_pool->busy > 0)
+         pthread_cond_wait(&ev_pool->done, &ev_pool->lock);
+      pthread_mutex_unlock(&ev_pool->lock);
+
+      return OK;
+   }
+#endif
+
+   /*--- Serial evaluation ---*/
+   for(i = 0; i < n; i++)
+      EV_call(ga_info, chrom[i]);
+
+   return OK;
+}
+
+#ifndef GA_NO_THREADS
+/*----------------------------------------------------------------------------
+| Evaluation thread: evaluate chroms of each batch until told to quit
+----------------------------------------------------------------------------*/
+void *EV_worker(
+   void *arg)
+{
+   EV_Pool_Ptr ev_pool = (EV_Pool_Ptr)arg;
+   long        seen = 0;
+   int         i;
+
+   pthread_mutex_lock(&ev_pool->lock);
+   while(TRUE) {
+
+      /*--- Wait for a new batch ---*/
+      while(ev_pool->round == seen && !ev_pool->quit)
+         pthread_cond_wait(&ev_pool->start, &ev_pool->lock);
+      if(ev_pool->quit) break;
+      seen = ev_pool->round;
+
+      /*--- Evaluate chroms until none are left ---*/
+      while(ev_pool->next < ev_pool->n) {
+         i = ev_pool->next++;
+         pthread_mutex_unlock(&ev_pool->lock);
+         EV_call(ev_pool->ga_info, ev_pool->chrom[i]);
+         pthread_mutex_lock(&ev_pool->lock);
+      }
+
+      /*--- Done with this batch ---*/
+      if(--ev_pool->busy == 0) pthread_cond_signal(&ev_pool->done);
+   }
+   pthread_mutex_unlock(&ev_pool->lock);
+
+   return NULL;
+}
+#endif
+
+/*----------------------------------------------------------------------------
+| Stop the evaluation threads and free the scratch of batches
+----------------------------------------------------------------------------*/
+int EV_stop(
+   GA_Info_Ptr ga_info)
+{
+#ifndef GA_NO_THREADS
+   EV_Pool_Ptr ev_pool;
+   int         i;
+#endif
+
+   /*--- Free scratch ---*/
+   free(ga_info->ev_parent);
+   free(ga_info->ev_miss);
+   free(ga_info->ev_hash);
+   free(ga_info->ev_same);
+   ga_info->ev_parent = ga_info->ev_miss = NULL;
+   ga_info->ev_hash   = NULL;
+   ga_info->ev_same   = NULL;
+   ga_info->ev_room   = 0;
+
+#ifndef GA_NO_THREADS
+   if(ga_info->ev_pool == NULL) return OK;
+   ev_pool = (EV_Pool_Ptr)ga_info->ev_pool;
+
+   /*--- Tell the threads to quit and wait for them ---*/
+   pthread_mutex_lock(&ev_pool->lock);
+   ev_pool->quit = TRUE;
+   pthread_cond_broadcast(&ev_pool->start);
+   pthread_mutex_unlock(&ev_pool->lock);
+   for(i = 0; i < ev_pool->nthreads; i++)
+      pthread_join(ev_pool->tid[i], NULL);
+
+   /*--- Free memory ---*/
+   pthread_mutex_destroy(&ev_pool->lock);
+   pthread_cond_destroy(&ev_pool->start);
+   pthread_cond_destroy(&ev_pool->done);
+   free(ev_pool->tid);
+   free(ev_pool);
+   ga_info->ev_pool = NULL;
+#endif
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Look up the fitness of a chrom in the cache, also giving the hash of its
+| genes for EV_store()
+----------------------------------------------------------------------------*/
+int EV_lookup(
+   GA_Info_Ptr ga_info,
+   Chrom_Ptr   chrom,
+   Word_Type   *hash)
+{
+   EV_Cache_Ptr cache;
+   EV_Entry_Ptr entry;
+   int          size;
+
+   /*--- No cache ---*/
+   if(ga_info->cache_size <= 0) return FALSE;
+
+   /*--- Allocate the cache on first use ---*/
+   if(ga_info->ev_cache == NULL) {
+      for(size = 1; size < ga_info->cache_size; size <<= 1);
+      cache = (EV_Cache_Ptr)calloc(1, sizeof(EV_Cache_Type));
+      if(cache == NULL) UT_error("EV_lookup: cache alloc failed");
+      cache->size  = size;
+      cache->entry = (EV_Entry_Ptr)calloc(size, sizeof(EV_Entry_Type));
+      if(cache->entry == NULL) UT_error("EV_lookup: entry alloc failed");
+      ga_info->ev_cache = cache;
+   }
+   cache = (EV_Cache_Ptr)ga_info->ev_cache;
+
+   *hash = CH_hash(chrom);
+   entry = &cache->entry[*hash & (cache->size - 1)];
+   if(!entry->used || entry->hash != *hash || entry->wait > 0) {
+      ga_info->cache_miss++;
+      return FALSE;
+   }
+
+   ga_info->cache_hit++;
+   EV_take(chrom, entry->fitness);
+
+   return TRUE;
+}
+
+/*----------------------------------------------------------------------------
+| Entry of the cache for a hash, NULL if there is no cache
+----------------------------------------------------------------------------*/
+EV_Entry_Ptr EV_entry(
+   GA_Info_Ptr ga_info,
+   Word_Type   hash)
+{
+   EV_Cache_Ptr cache;
+
+   if(ga_info->ev_cache == NULL) return NULL;
+   cache = (EV_Cache_Ptr)ga_info->ev_cache;
+
+   return &cache->entry[hash & (cache->size - 1)];
+}
+
+/*----------------------------------------------------------------------------
+| Give a chrom the fitness of its genes found in the cache
+----------------------------------------------------------------------------*/
+int EV_take(
+   Chrom_Ptr chrom,
+   double    fitness)
+{
+   /*--- The evaluation state no longer matches the genes ---*/
+   chrom->fitness = fitness;
+   if(chrom->num_changed != 0) chrom->ev_valid = FALSE;
+   chrom->fit_valid   = TRUE;
+   chrom->num_changed = 0;
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Store the fitness of a chrom in the cache
+----------------------------------------------------------------------------*/
+int EV_store(
+   GA_Info_Ptr ga_info,
+   Chrom_Ptr   chrom,
+   Word_Type   hash)
+{
+   EV_Cache_Ptr cache;
+   EV_Entry_Ptr entry;
+
+   if(ga_info->ev_cache == NULL) return OK;
+   cache = (EV_Cache_Ptr)ga_info->ev_cache;
+
+   /*--- Evict whatever was there ---*/
+   entry = &cache->entry[hash & (cache->size - 1)];
+   if(entry->used && entry->hash != hash) ga_info->cache_evict++;
+
+   entry->hash    = hash;
+   entry->fitness = chrom->fitness;
+   entry->used    = TRUE;
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Free the fitness cache
+----------------------------------------------------------------------------*/
+int EV_cache_free(
+   GA_Info_Ptr ga_info)
+{
+   EV_Cache_Ptr cache;
+
+   if(ga_info->ev_cache == NULL) return OK;
+   cache = (EV_Cache_Ptr)ga_info->ev_cache;
+
+   free(cache->entry);
+   free(cache);
+   ga_info->ev_cache = NULL;
+
+   return OK;
+}
+
+/*============================================================================
+| (c) Copyright Arthur L. Corcoran, 1992, 1993.  All rights reserved.
+| (c) Copyright IA UPM - Group 5, 2020.  All rights reserved.
+|
+| Mutation operators 
+|
+| Bit String Representations
+|    MU_simple_invert() - random bit inversion based on mutation rate
+|    MU_simple_random() - random bit value based on mutation rate
+|
+| Any Representation
+|    MU_swap()          - random element swap based on mutation rate
+|
+| Interface
+|    MU_table[]   - used in selection of mutation method
+|    MU_set_fun() - set and select user defined mutation function
+|    MU_select()  - select mutation function by name
+|    MU_name()    - get name of current mutation function
+|    MU_fun()     - setup and perform current mutation operator
+============================================================================*/
+
+/*============================================================================
+|                     Mutation interface
+============================================================================*/
+/*----------------------------------------------------------------------------
+| Mutation table
+----------------------------------------------------------------------------*/
+FN_Table_Type MU_table[] = {
+   {  NULL,           NULL             }, /* user defined function */
+   { "simple_invert", MU_simple_invert },
+   { "simple_random", MU_simple_random },
+   { "swap",          MU_swap          },
+   { "float_random",  MU_float_random  },
+   { "float_rnd_pert",MU_float_rnd_pert},
+   { "float_LS",      MU_float_LS      },
+   { "float_gauss_pert",MU_float_gauss_pert},
+   { NULL,            NULL             }
+};
+
+/*----------------------------------------------------------------------------
+| Select user mutation method
+----------------------------------------------------------------------------*/
+MU_set_fun(
+   GA_Info_Ptr  ga_info,
+   char         *fn_name,
+   FN_Ptr       fn_ptr)
+{
+   return FN_set_fun(ga_info, MU_table, fn_name, fn_ptr, &ga_info->MU_fun);
 }
 
 /*----------------------------------------------------------------------------
@@ -2452,10 +4102,14 @@ MU_fun(
    Chrom_Ptr   chrom)
 {
    /*--- Random chance to mutate ---*/
-   if(RAND_FRAC() <= ga_info->mu_rate && ga_info->MU_fun != NULL) {
+   if(RAND_FRAC(&ga_info->rng) <= ga_info->mu_rate && ga_info->MU_fun != NULL) {
+      CH_own(chrom, TRUE);
       ga_info->MU_fun(ga_info, chrom);
       ga_info->num_mut++;
       ga_info->tot_mut++;
+
+      /*--- User defined operators do not report changed loci ---*/
+      if(ga_info->MU_fun == MU_table[0].fun) chrom->num_changed = -1;
    }
 }
 
@@ -2472,10 +4126,14 @@ MU_simple_invert(
    int idx;
 
    /*--- Select bit at random ---*/
-   idx = RAND_DOM(chrom->idx_min, chrom->length-1);
+   idx = RAND_DOM(&ga_info->rng, chrom->idx_min, chrom->length-1);
 
    /*--- Invert selected bit ---*/
-   chrom->gene[idx] = chrom->gene[idx] ? 0 : 1;
+   if(CH_packed(chrom))
+      chrom->bits[idx / WORD_BITS] ^= (Word_Type)1 << (idx % WORD_BITS);
+   else
+      chrom->gene[idx] = chrom->gene[idx] ? 0 : 1;
+   CH_changed(chrom, idx);
 }
 
 /*----------------------------------------------------------------------------
@@ -2484,13 +4142,21 @@ MU_simple_invert(
 MU_simple_random(GA_Info_Ptr ga_info,
    Chrom_Ptr chrom)
 {
-   int idx;
+   int       idx;
+   Gene_Type old;
 
    /*--- Select bit at random ---*/
-   idx = RAND_DOM(chrom->idx_min, chrom->length-1);
+   idx = RAND_DOM(&ga_info->rng, chrom->idx_min, chrom->length-1);
 
    /*--- Assign random value to bit ---*/
-   chrom->gene[idx] = RAND_BIT();
+   old = CH_gene(chrom, idx);
+   if(CH_packed(chrom)) {
+      if(RAND_BIT(&ga_info->rng)) BIT_SET(chrom->bits, idx);
+      else           BIT_CLR(chrom->bits, idx);
+   } else {
+      chrom->gene[idx] = RAND_BIT(&ga_info->rng);
+   }
+   if(CH_gene(chrom, idx) != old) CH_changed(chrom, idx);
 }
 
 /*----------------------------------------------------------------------------
@@ -2503,13 +4169,19 @@ MU_swap(GA_Info_Ptr ga_info,
    int       i, j;
 
    /*--- Select two bits at random (can be same) ---*/
-   i = RAND_DOM(chrom->idx_min, chrom->length-1);
-   j = RAND_DOM(chrom->idx_min, chrom->length-1);
+   i = RAND_DOM(&ga_info->rng, chrom->idx_min, chrom->length-1);
+   j = RAND_DOM(&ga_info->rng, chrom->idx_min, chrom->length-1);
 
    /*--- Swap the elements ---*/
    tmp            = chrom->gene[i];
    chrom->gene[i] = chrom->gene[j];
    chrom->gene[j] = tmp;
+
+   /*--- Nothing changes if the elements are equal ---*/
+   if(chrom->gene[i] != chrom->gene[j]) {
+      CH_changed(chrom, i);
+      CH_changed(chrom, j);
+   }
 }
 
 
@@ -2522,19 +4194,20 @@ MU_float_rnd_pert(GA_Info_Ptr ga_info,
    int       i;
 
    /*--- Select one element at random ---*/
-   i = RAND_DOM(chrom->idx_min, chrom->length);
+   i = RAND_DOM(&ga_info->rng, chrom->idx_min, chrom->length);
 
    //patch
    if(i!=chrom->length)
    {
        /*--- Generate randomly perturbed element ---*/
-       chrom->gene[i] += ga_info->pert_range*(1.0 - 2.0*RAND_FRAC()) ;
+       chrom->gene[i] += ga_info->pert_range*(1.0 - 2.0*RAND_FRAC(&ga_info->rng)) ;
 	   // + 	 ga_info->mut_bias[i]; 
    
    if( chrom->gene[i]>1)
      chrom->gene[i]=1;
    if( chrom->gene[i]<0)
      chrom->gene[i]=0;
+   CH_changed(chrom, i);
    
    }
 }
@@ -2549,14 +4222,15 @@ MU_float_random(GA_Info_Ptr ga_info,
    int       i;
 
    /*--- Select one element at random ---*/
-   i = RAND_DOM(chrom->idx_min, chrom->length-1);
+   i = RAND_DOM(&ga_info->rng, chrom->idx_min, chrom->length-1);
 
    /*--- Generate random element ---*/
-   chrom->gene[i] = RAND_FRAC();
+   chrom->gene[i] = RAND_FRAC(&ga_info->rng);
    if( chrom->gene[i]>1)
      chrom->gene[i]=1;
    if( chrom->gene[i]<0)
      chrom->gene[i]=0;
+   CH_changed(chrom, i);
 
 }
 
@@ -2582,11 +4256,12 @@ MU_float_LS(
 	  prev_fit=chrom->fitness;
 	  prev_val= chrom->gene[i];
 	  
-	  chrom->gene[i] += 0.1*(1.0 - 2.0*RAND_FRAC());
+	  chrom->gene[i] += 0.1*(1.0 - 2.0*RAND_FRAC(&ga_info->rng));
 	  if( chrom->gene[i]>1)
 	    chrom->gene[i]=1;
 	  if( chrom->gene[i]<0)
 	    chrom->gene[i]=0;
+	  CH_changed(chrom, i);
 	  
 	  //obj_fun(chrom);
 	  new_fit=chrom->fitness;
@@ -2627,12 +4302,12 @@ MU_float_gauss_pert(GA_Info_Ptr ga_info,
    
 
    // NB pert in [-1,1], gaussian: mean=0, var=1
-   pert=(2*(RAND_DOM(0,c2)+RAND_DOM(0,c2)+RAND_DOM(0,c2))-3*(c2))*c3;
+   pert=(2*(RAND_DOM(&ga_info->rng, 0,c2)+RAND_DOM(&ga_info->rng, 0,c2)+RAND_DOM(&ga_info->rng, 0,c2))-3*(c2))*c3;
 
-   //pert=gaussian_random();
+   //pert=gaussian_random(&ga_info->rng);
 
    /*--- Select one element at random ---*/
-   i = RAND_DOM(chrom->idx_min, chrom->length-1);
+   i = RAND_DOM(&ga_info->rng, chrom->idx_min, chrom->length-1);
 
    /*--- Generate randomly perturbed element ---*/
    chrom->gene[i] += ga_info->pert_range*pert ;//+ ga_info->mut_bias[i];
@@ -2643,11 +4318,12 @@ MU_float_gauss_pert(GA_Info_Ptr ga_info,
      chrom->gene[i]=1;
    if( chrom->gene[i]<0)
      chrom->gene[i]=0;
+   CH_changed(chrom, i);
 }
 
 
 
-double gaussian_random(void)
+double gaussian_random(Rand_Ptr rng)
 {
   static int next_gaussian = 0;
   static double saved_gaussian_value;
@@ -2656,8 +4332,8 @@ double gaussian_random(void)
 
   if (next_gaussian == 0) {
     do {
-      v1 = 2.0*RAND_FRAC()-1.0;
-      v2 = 2.0*RAND_FRAC()-1.0;
+      v1 = 2.0*RAND_FRAC(rng)-1.0;
+      v2 = 2.0*RAND_FRAC(rng)-1.0;
       rsq = v1*v1+v2*v2;
     } while (rsq >= 1.0 || rsq == 0.0);
     fac = sqrt(-2.0*log(rsq)/rsq);
@@ -2675,53 +4351,345 @@ double gaussian_random(void)
 
 
 /*============================================================================
-| (c) Copyright Arthur L. Corcoran, 1992, 1993.  All rights reserved.
 | (c) Copyright IA UPM - Group 5, 2020.  All rights reserved.
 |
-| Pool management
+| Local search
 |
-| Functions:
-|    PL_alloc()    - allocate a pool
-|    PL_resize()   - resize a pool
-|    PL_free()     - deallocate a pool
-|    PL_valid()    - is a pool valid?
-|    PL_reset()    - reset a pool
-|    PL_eval()     - evaluate a pool
-|    PL_get_num()  - get a number
-|    PL_generate() - generate a pool
-|    PL_read()     - read a pool from a file
-|    PL_rand()     - generate a random pool
-|    PL_stats()    - calculate pool statistics
-|    PL_index()    - index a pool
-|    PL_update_ptf() - update the percent of total fitness in a pool
-|    PL_clean()    - empty a pool
-|    PL_append()   - append a chrom to a pool
-|    PL_insert()   - insert a chrom in a pool at a spec loc
-|    PL_remove()   - remove a chrom from a pool
-|    PL_move()     - move a chrom in a pool
-|    PL_swap()     - swap two chroms in a pool
-|    PL_sort()     - sort a pool
+| Max Clique (bit strings, needs ga_info->graph)
+|    LS_clique()     - repair to a clique, then add and plateau swap moves
+|       LS_clique_add() - greedily add nodes adjacent to the whole clique
+|
+| Interface
+|    LS_table[]   - used in selection of local search method
+|    LS_set_fun() - set and select user defined local search function
+|    LS_select()  - select local search function by name
+|    LS_name()    - get name of current local search function
+|    LS_fun()     - setup and perform current local search
+|
+| NOTE: Local search runs on each child after mutation (with probability
+|       ls_rate) and may change any of its genes.  Budgets are in ls_iter.
 ============================================================================*/
 
+/*============================================================================
+|                     Local search interface
+============================================================================*/
 /*----------------------------------------------------------------------------
-| Allocate a pool
+| Local search table
 ----------------------------------------------------------------------------*/
-Pool_Ptr PL_alloc(   int max_size)
-{
-   Pool_Ptr pool;
+FN_Table_Type LS_table[] = {
+   {  NULL,           NULL             }, /* user defined function */
+   { "clique",        LS_clique        },
+   { NULL,            NULL             }
+};
 
-   /*--- Error check ---*/
-   if(max_size <= 0) UT_error("PL_alloc: invalid max_size");
+/*----------------------------------------------------------------------------
+| Select user local search method
+----------------------------------------------------------------------------*/
+int LS_set_fun(
+   GA_Info_Ptr  ga_info,
+   char         *fn_name,
+   FN_Ptr       fn_ptr)
+{
+   return FN_set_fun(ga_info, LS_table, fn_name, fn_ptr, &ga_info->LS_fun);
+}
 
-   /*--- Allocate memory for pool ---*/
-   pool = (Pool_Ptr)calloc(1, sizeof(Pool_Type));
-   if(pool == NULL) UT_error("PL_alloc: pool alloc failed");
-   pool->max_size = max_size;
+/*----------------------------------------------------------------------------
+| Select local search method ("none" for no local search)
+----------------------------------------------------------------------------*/
+int LS_select(
+   GA_Info_Ptr  ga_info,
+   char         *fn_name)
+{
+   if(!strcmp(fn_name, "none")) {
+      ga_info->LS_fun = NULL;
+      return OK;
+   }
+   return FN_select(ga_info, LS_table, fn_name, &ga_info->LS_fun);
+}
 
-   /*--- Allocate memory for chromosome pointers ---*/
-   pool->chrom = (Chrom_Ptr *)calloc(max_size, sizeof(Chrom_Ptr));
+/*----------------------------------------------------------------------------
+| Local search name
+----------------------------------------------------------------------------*/
+char *LS_name(
+   GA_Info_Ptr  ga_info)
+{
+   if(ga_info->LS_fun == NULL) return "none";
+   return FN_name(ga_info, LS_table, ga_info->LS_fun);
+}
+
+/*----------------------------------------------------------------------------
+| Local search interface
+----------------------------------------------------------------------------*/
+int LS_fun(
+   GA_Info_Ptr ga_info,
+   Chrom_Ptr   chrom)
+{
+   /*--- No local search ---*/
+   if(ga_info->LS_fun == NULL) return OK;
+
+   /*--- Random chance to search ---*/
+   if(ga_info->ls_rate < 1.0 && RAND_FRAC(&ga_info->rng) > ga_info->ls_rate) return OK;
+
+   CH_own(chrom, TRUE);
+   ga_info->LS_fun(ga_info, chrom);
+   ga_info->tot_ls++;
+
+   /*--- User defined searches do not report changed loci ---*/
+   if(ga_info->LS_fun == LS_table[0].fun) chrom->num_changed = -1;
+
+   return OK;
+}
+
+/*============================================================================
+|                     Local search methods
+============================================================================*/
+/*----------------------------------------------------------------------------
+| Max clique local search
+|
+| The selected nodes are first repaired into a clique by dropping the node
+| with the most non-neighbours in the set until none is left.  The clique is
+| then greedily extended.  Then, up to ls_iter times, a random node adjacent
+| to all the clique but one member is swapped in for that member (the member
+| is tabu for the next swap) and the clique extended again.  The largest
+| clique found is written back to the chrom.
+----------------------------------------------------------------------------*/
+int LS_clique(
+   GA_Info_Ptr ga_info,
+   Chrom_Ptr   chrom)
+{
+   Graph_Ptr graph;
+   Word_Ptr  row;
+   Word_Type w;
+   int       n, nw, i, j, k, it, size, best_size, min, count, pick, tabu;
+
+   /*--- Error check ---*/
+   graph = ga_info->graph;
+   if(!GR_valid(graph)) UT_error("LS_clique: invalid graph");
+   if(chrom->length > graph->nnodes) UT_error("LS_clique: chrom too long");
+
+   n  = chrom->length;
+   nw = NUM_WORDS(n);
+   {
+   Word_Type set[nw], old[nw], best[nw];
+   int       deg[n];
+
+   /*--- Pack selected nodes ---*/
+   if(CH_packed(chrom)) {
+      memcpy(set, chrom->bits, sizeof(set));
+   } else {
+      memset(set, 0, sizeof(set));
+      for(i = 0; i < n; i++)
+         if(chrom->gene[i] == 1) BIT_SET(set, i);
+   }
+   memcpy(old, set, sizeof(set));
+
+   /*--- Neighbours of each selected node within the set ---*/
+   size = 0;
+   for(k = 0; k < nw; k++)
+      for(w = set[k]; w; w &= w - 1) {
+         i = k * WORD_BITS + LOWBIT(w);
+         row = GR_row(graph, i);
+         deg[i] = 0;
+         for(j = 0; j < nw; j++) deg[i] += POPCOUNT(row[j] & set[j]);
+         size++;
+      }
+
+   /*--- Repair: drop the node with most non-neighbours in the set ---*/
+   while(size > 1) {
+      min = -1;
+      for(k = 0; k < nw; k++)
+         for(w = set[k]; w; w &= w - 1) {
+            i = k * WORD_BITS + LOWBIT(w);
+            if(min < 0 || deg[i] < deg[min]) min = i;
+         }
+      if(deg[min] >= size - 1) break;
+
+      BIT_CLR(set, min);
+      size--;
+      row = GR_row(graph, min);
+      for(k = 0; k < nw; k++)
+         for(w = set[k] & row[k]; w; w &= w - 1)
+            deg[k * WORD_BITS + LOWBIT(w)]--;
+   }
+
+   /*--- Add ---*/
+   size += LS_clique_add(graph, set, n);
+   memcpy(best, set, sizeof(set));
+   best_size = size;
+
+   /*--- Plateau swaps ---*/
+   tabu = -1;
+   for(it = 0; it < ga_info->ls_iter && size > 0; it++) {
+
+      /*--- Count nodes adjacent to all the clique but one member ---*/
+      count = 0;
+      for(i = 0; i < n; i++) {
+         if(i == tabu || BIT_TEST(set, i)) continue;
+         row = GR_row(graph, i);
+         for(j = k = 0; k < nw && j < 2; k++) j += POPCOUNT(set[k] & ~row[k]);
+         if(j == 1) count++;
+      }
+      if(count == 0) break;
+
+      /*--- Pick one at random ---*/
+      pick = RAND_DOM(&ga_info->rng, 0, count-1);
+      for(i = 0; i < n; i++) {
+         if(i == tabu || BIT_TEST(set, i)) continue;
+         row = GR_row(graph, i);
+         for(j = k = 0; k < nw && j < 2; k++) j += POPCOUNT(set[k] & ~row[k]);
+         if(j == 1 && pick-- == 0) break;
+      }
+
+      /*--- Swap it in for the member it is not adjacent to ---*/
+      for(k = 0; k < nw; k++)
+         if((w = set[k] & ~row[k]) != 0) {
+            tabu = k * WORD_BITS + LOWBIT(w);
+            break;
+         }
+      BIT_CLR(set, tabu);
+      BIT_SET(set, i);
+
+      /*--- Extend ---*/
+      size += LS_clique_add(graph, set, n);
+      if(size > best_size) {
+         memcpy(best, set, sizeof(set));
+         best_size = size;
+      }
+   }
+
+   /*--- Write back the best clique and record what changed ---*/
+   for(k = 0; k < nw; k++)
+      for(w = best[k] ^ old[k]; w; w &= w - 1) {
+         i = k * WORD_BITS + LOWBIT(w);
+         if(CH_packed(chrom)) chrom->bits[k] ^= (Word_Type)1 << (i % WORD_BITS);
+         else                 chrom->gene[i] = BIT_TEST(best, i);
+         CH_changed(chrom, i);
+      }
+   }
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Greedily add to a clique the candidate (node adjacent to all the clique)
+| with the most neighbours among the other candidates, until none is left.
+| Returns the number of nodes added.
+----------------------------------------------------------------------------*/
+int LS_clique_add(
+   Graph_Ptr graph,
+   Word_Ptr  set,
+   int       n)
+{
+   Word_Ptr  row;
+   Word_Type w;
+   int       nw, i, k, c, best, best_deg, deg, added;
+
+   nw = NUM_WORDS(n);
+   {
+   Word_Type cand[nw];
+
+   /*--- Candidates: adjacent to every member ---*/
+   for(k = 0; k < nw; k++) cand[k] = ~set[k];
+   if(n % WORD_BITS) cand[nw-1] &= ((Word_Type)1 << (n % WORD_BITS)) - 1;
+   for(k = 0; k < nw; k++)
+      for(w = set[k]; w; w &= w - 1) {
+         row = GR_row(graph, k * WORD_BITS + LOWBIT(w));
+         for(i = 0; i < nw; i++) cand[i] &= row[i];
+      }
+
+   /*--- Add the best connected candidate while there is one ---*/
+   added = 0;
+   while(TRUE) {
+      best = -1;
+      best_deg = -1;
+      for(k = 0; k < nw; k++)
+         for(w = cand[k]; w; w &= w - 1) {
+            c = k * WORD_BITS + LOWBIT(w);
+            row = GR_row(graph, c);
+            for(deg = i = 0; i < nw; i++) deg += POPCOUNT(row[i] & cand[i]);
+            if(deg > best_deg) {
+               best = c;
+               best_deg = deg;
+            }
+         }
+      if(best < 0) break;
+
+      BIT_SET(set, best);
+      row = GR_row(graph, best);
+      for(i = 0; i < nw; i++) cand[i] &= row[i];
+      added++;
+   }
+   }
+
+   return added;
+}
+
+/*============================================================================
+| (c) Copyright Arthur L. Corcoran, 1992, 1993.  All rights reserved.
+| (c) Copyright IA UPM - Group 5, 2020.  All rights reserved.
+|
+| Pool management
+|
+| Functions:
+|    PL_alloc()    - allocate a pool
+|    PL_resize()   - resize a pool
+|    PL_free()     - deallocate a pool
+|    PL_valid()    - is a pool valid?
+|    PL_reset()    - reset a pool
+|    PL_eval()     - evaluate a pool
+|    PL_get_num()  - get a number
+|    PL_generate() - generate a pool
+|    PL_read()     - read a pool from a file
+|    PL_rand()     - generate a random pool
+|    PL_stats()    - calculate pool statistics
+|    PL_stats_build() - full pass for the running statistics of a pool
+|    PL_stats_out() - take chroms out of the running statistics
+|    PL_stats_in()  - put chroms (back) in the running statistics
+|    PL_stats_fix() - bring swapped chroms into the running statistics
+|    PL_stats_first() - first chrom of an in order pool with a fitness
+|    PL_stats_check() - compare the running statistics with a full pass
+|    PL_weakest()  - weakest chrom of a pool
+|    PL_first_weaker() - first chrom of a pool weaker than a chrom
+|    PL_in_order() - is a pool in PL_sort() order?
+|    PL_index()    - index a pool
+|    PL_update_ptf() - update the percent of total fitness in a pool
+|    PL_fitness()  - fitness of every chrom in a pool, as an array
+|    PL_clean()    - empty a pool
+|    PL_append()   - append a chrom to a pool
+|    PL_append_move() - append a chrom to a pool by handing it over
+|    PL_insert()   - insert a chrom in a pool at a spec loc
+|    PL_remove()   - remove a chrom from a pool
+|    PL_move()     - move a chrom in a pool
+|    PL_swap()     - swap two chroms in a pool
+|    PL_shift()    - move a chrom, shifting those in between
+|    PL_sort()     - sort a pool
+|    PL_slab()     - give a pool a slab of chrom slots
+|    PL_new_chrom() - a fresh chrom for a pool, from its slab if possible
+============================================================================*/
+
+/*----------------------------------------------------------------------------
+| Allocate a pool
+----------------------------------------------------------------------------*/
+Pool_Ptr PL_alloc(   int max_size)
+{
+   Pool_Ptr pool;
+
+   /*--- Error check ---*/
+   if(max_size <= 0) UT_error("PL_alloc: invalid max_size");
+
+   /*--- Allocate memory for pool ---*/
+   pool = (Pool_Ptr)calloc(1, sizeof(Pool_Type));
+   if(pool == NULL) UT_error("PL_alloc: pool alloc failed");
+   pool->max_size = max_size;
+
+   /*--- Allocate memory for chromosome pointers ---*/
+   pool->chrom = (Chrom_Ptr *)calloc(max_size, sizeof(Chrom_Ptr));
    if(pool->chrom == NULL) UT_error("PL_alloc: chrom alloc failed");
 
+   /*--- Allocate memory for fitness array ---*/
+   pool->fit = (double *)calloc(max_size, sizeof(double));
+   if(pool->fit == NULL) UT_error("PL_alloc: fit alloc failed");
+
    /*--- Put in magic cookie ---*/
    pool->magic_cookie = PL_cookie;
 
@@ -2740,7 +4708,7 @@ PL_resize(
    Pool_Ptr  pool,
    int       new_size)
 {
-   int old_size;
+   int i, old_size;
 
    /*--- Error check ---*/
    if(!PL_valid(pool)) UT_error("PL_resize: invalid pool");
@@ -2752,13 +4720,17 @@ PL_resize(
    /*--- Reallocate memory for chromosome pointers ---*/
    pool->chrom = (Chrom_Ptr *)realloc(pool->chrom, new_size*sizeof(Chrom_Ptr));
    if(pool->chrom == NULL) UT_error("PL_resize: chrom realloc failed");
+   pool->fit = (double *)realloc(pool->fit, new_size*sizeof(double));
+   if(pool->fit == NULL) UT_error("PL_resize: fit realloc failed");
+   PL_touch(pool);
 
    /*--- Update pool size ---*/
    old_size       = pool->max_size;
    pool->max_size = new_size;
 
-   /*--- Make any new chromosomes NULL ---*/
-   if(new_size > old_size) PL_clean(pool, old_size, new_size);
+   /*--- Make any new chromosomes NULL (realloc leaves them undefined) ---*/
+   for(i = old_size; i < new_size; i++)
+      pool->chrom[i] = NULL;
 }
 
 /*----------------------------------------------------------------------------
@@ -2780,6 +4752,28 @@ PL_free(   Pool_Ptr pool)
       pool->chrom = NULL;
    }
 
+   /*--- Release memory for chromosome slots and fitness array ---*/
+   if(pool->slab != NULL) CH_slab_free(pool->slab);
+   pool->slab = NULL;
+   if(pool->fit != NULL) free(pool->fit);
+   pool->fit = NULL;
+
+   /*--- Release memory for roulette wheel and batch selection ---*/
+   if(pool->wheel != NULL) free(pool->wheel);
+   pool->wheel = NULL;
+   if(pool->pick != NULL) free(pool->pick);
+   pool->pick = NULL;
+   if(pool->rank_prob != NULL) free(pool->rank_prob);
+   if(pool->rank_alias != NULL) free(pool->rank_alias);
+   pool->rank_prob  = NULL;
+   pool->rank_alias = NULL;
+
+   /*--- Release memory for running statistics ---*/
+   if(pool->stat_min != NULL) free(pool->stat_min);
+   if(pool->stat_max != NULL) free(pool->stat_max);
+   pool->stat_min = NULL;
+   pool->stat_max = NULL;
+
    /*--- Put in a NULL magic cookie ---*/
    pool->magic_cookie = NL_cookie;
 
@@ -2833,6 +4827,7 @@ PL_reset(  Pool_Ptr pool)
    pool->max_index = -1;
    pool->minimize = TRUE;
    pool->sorted   = FALSE;
+   PL_touch(pool);
 }
 
 /*----------------------------------------------------------------------------
@@ -2842,17 +4837,13 @@ PL_eval(
    GA_Info_Ptr ga_info,
    Pool_Ptr pool)
 {
-   int i;
-
    /*--- Error check ---*/
    if(!CF_valid(ga_info)) UT_error("PL_eval: invalid ga_info");
    if(!PL_valid(pool)) UT_error("PL_eval: invalid pool");
 
    /*--- Evaluate each chromosome ---*/
-   for(i = 0; i < pool->size; i++) {
-      ga_info->EV_fun(pool->chrom[i]);
-	 // printf("%d -> %g\n",i,pool->chrom[i]->fitness);	
-   }
+   EV_batch(ga_info, pool->chrom, pool->size);
+   PL_touch(pool);
 }
 
 /*============================================================================
@@ -2967,11 +4958,11 @@ PL_generate(
 
       case IP_RANDOM:
          PL_rand(pool, ga_info->pool_size, ga_info->chrom_len, 
-                    ga_info->datatype);
+                    ga_info->datatype, ga_info->rand_seed);
          break;
       case IP_RANDOM01:
          PL_rand01(pool, ga_info->pool_size, ga_info->chrom_len, 
-                    ga_info->datatype);
+                    ga_info->datatype, ga_info->rand_seed);
          break;
 
       case IP_NONE:
@@ -3061,10 +5052,14 @@ PL_read(
 ----------------------------------------------------------------------------*/
 PL_rand(
    Pool_Ptr pool,
-   int      pool_size,int   chrom_len, int  datatype)
+   int      pool_size,int   chrom_len, int  datatype,
+   int      seed)
 {
    int       i, j, idx;
    Chrom_Ptr chrom;
+   Rand_Type stream;
+   Rand_Ptr  rng = &stream;
+   Word_Type mask[NUM_WORDS(chrom_len) + 1];
 
    /*--- Error check ---*/
    if(!PL_valid(pool)) UT_error("PL_rand: invalid pool");
@@ -3075,6 +5070,7 @@ PL_rand(
       case DT_INT:
       case DT_INT_PERM:
       case DT_REAL:
+      case DT_PACKED_BIT:
          break;
       default: UT_error("PL_rand: Invalid datatype");
    }
@@ -3087,29 +5083,40 @@ PL_rand(
    /*--- For each chromosome to be generated ---*/
    for(i = 0; i < pool_size; i++) {
 
+      /*--- Drop a chromosome of the other kind ---*/
+      if(CH_valid(pool->chrom[pool->size]) && 
+         CH_packed(pool->chrom[pool->size]) != (datatype == DT_PACKED_BIT)) {
+         CH_free(pool->chrom[pool->size]);
+         pool->chrom[pool->size] = NULL;
+      }
+
       /*--- Allocate or reuse a chromosome ---*/
       if(CH_valid(pool->chrom[pool->size])) {
          chrom = pool->chrom[pool->size];
          CH_resize(chrom, chrom_len);
          pool->chrom[pool->size] = NULL;
       } else {
-         chrom = CH_alloc(chrom_len);
+         chrom = PL_new_chrom(pool, chrom_len, datatype);
       }
 
+      /*--- Each chrom has its own stream, so the order does not matter ---*/
+      RN_stream(rng, seed, RN_INIT, i);
+
       /*--- Generate random genes ---*/
       switch(datatype) {
 
          case DT_BIT:
-            /*--- Random bit ---*/
+            /*--- Random bit, drawn a word at a time ---*/
+            RN_bits(rng, mask, NUM_WORDS(chrom_len));
             for(j = 0; j < chrom_len; j++)
-               chrom->gene[j] = (Gene_Type)RAND_BIT();
+               chrom->gene[j] = (Gene_Type)BIT_TEST(mask, j);
             chrom->length = chrom_len;
             break;
 
          case DT_INT:
             /*--- Random integers from an arbitrary domain ---*/
             for(j = 0; j < chrom_len; j++)
-               chrom->gene[j] = (Gene_Type)RAND_DOM(0,chrom_len);
+               chrom->gene[j] = (Gene_Type)RAND_DOM(rng, 0,chrom_len);
             chrom->length = chrom_len;
             break;
 
@@ -3123,10 +5130,10 @@ PL_rand(
 	    
 
             for(j = 0; j < chrom_len; j++) {
-               idx = RAND_DOM(0,chrom_len-1);
+               idx = RAND_DOM(rng, 0,chrom_len-1);
 	 
 	       while(chrom->gene[idx] != -1) 
-                  idx = RAND_DOM(0,chrom_len-1);
+                  idx = RAND_DOM(rng, 0,chrom_len-1);
 
                chrom->gene[idx] = (Gene_Type)(j + 1);
 
@@ -3140,8 +5147,14 @@ PL_rand(
             /*--- Random reals from an arbitrary domain ---*/
             for(j = 0; j < chrom_len; j++)
                chrom->gene[j] = 
-                  (double)RAND_DOM(0,chrom_len-1) + (double)RAND_FRAC();
+                  (double)RAND_DOM(rng, 0,chrom_len-1) + (double)RAND_FRAC(rng);
+            chrom->length = chrom_len;
+            break;
+
+         case DT_PACKED_BIT:
+            /*--- Random bits, a word at a time ---*/
             chrom->length = chrom_len;
+            CH_rand_bits(chrom, rng);
             break;
 
          /*--- Should never reach here ---*/
@@ -3157,10 +5170,14 @@ PL_rand(
 ----------------------------------------------------------------------------*/
 PL_rand01(
    Pool_Ptr pool,
-   int      pool_size, int  chrom_len, int  datatype)
+   int      pool_size, int  chrom_len, int  datatype,
+   int      seed)
 {
    int       i, j, idx;
    Chrom_Ptr chrom;
+   Rand_Type stream;
+   Rand_Ptr  rng = &stream;
+   Word_Type mask[NUM_WORDS(chrom_len) + 1];
 
    /*--- Error check ---*/
    if(!PL_valid(pool)) UT_error("PL_rand: invalid pool");
@@ -3171,6 +5188,7 @@ PL_rand01(
       case DT_INT:
       case DT_INT_PERM:
       case DT_REAL:
+      case DT_PACKED_BIT:
          break;
       default: UT_error("PL_rand: Invalid datatype");
    }
@@ -3181,29 +5199,40 @@ PL_rand01(
    /*--- For each chromosome to be generated ---*/
    for(i = 0; i < pool_size; i++) {
 
+      /*--- Drop a chromosome of the other kind ---*/
+      if(CH_valid(pool->chrom[pool->size]) && 
+         CH_packed(pool->chrom[pool->size]) != (datatype == DT_PACKED_BIT)) {
+         CH_free(pool->chrom[pool->size]);
+         pool->chrom[pool->size] = NULL;
+      }
+
       /*--- Allocate or reuse a chromosome ---*/
       if(CH_valid(pool->chrom[pool->size])) {
          chrom = pool->chrom[pool->size];
          CH_resize(chrom, chrom_len);
          pool->chrom[pool->size] = NULL;
       } else {
-         chrom = CH_alloc(chrom_len);
+         chrom = PL_new_chrom(pool, chrom_len, datatype);
       }
 
+      /*--- Each chrom has its own stream, so the order does not matter ---*/
+      RN_stream(rng, seed, RN_INIT, i);
+
       /*--- Generate random genes ---*/
       switch(datatype) {
 
          case DT_BIT:
-            /*--- Random bit ---*/
+            /*--- Random bit, drawn a word at a time ---*/
+            RN_bits(rng, mask, NUM_WORDS(chrom_len));
             for(j = 0; j < chrom_len; j++)
-               chrom->gene[j] = (Gene_Type)RAND_BIT();
+               chrom->gene[j] = (Gene_Type)BIT_TEST(mask, j);
             chrom->length = chrom_len;
             break;
 
          case DT_INT:
             /*--- Random integers from an arbitrary domain ---*/
             for(j = 0; j < chrom_len; j++)
-               chrom->gene[j] = (Gene_Type)RAND_DOM(0,chrom_len);
+               chrom->gene[j] = (Gene_Type)RAND_DOM(rng, 0,chrom_len);
             chrom->length = chrom_len;
             break;
 
@@ -3212,19 +5241,24 @@ PL_rand01(
             for(j = 0; j < chrom_len; j++) 
                chrom->gene[j] = (Gene_Type)-1;
             for(j = 0; j < chrom_len; j++) {
-               idx = RAND_DOM(0,chrom_len-1);
+               idx = RAND_DOM(rng, 0,chrom_len-1);
                while(chrom->gene[idx] != -1) 
-                  idx = RAND_DOM(0,chrom_len-1);
+                  idx = RAND_DOM(rng, 0,chrom_len-1);
                chrom->gene[idx] = (Gene_Type)(j + 1);
             }
             chrom->length = chrom_len;
             break;
 
          case DT_REAL:
-            /*--- Random reals from an arbitrary domain ---*/
-            for(j = 0; j < chrom_len; j++)
-               chrom->gene[j] =  (double)RAND_FRAC();
+            /*--- Random reals in [0,1), drawn in bulk ---*/
+            RN_fracs(rng, chrom->gene, chrom_len);
+            chrom->length = chrom_len;
+            break;
+
+         case DT_PACKED_BIT:
+            /*--- Random bits, a word at a time ---*/
             chrom->length = chrom_len;
+            CH_rand_bits(chrom, rng);
             break;
 
          /*--- Should never reach here ---*/
@@ -3246,9 +5280,8 @@ PL_stats(
    GA_Info_Ptr ga_info,
    Pool_Ptr    pool)
 {
-   unsigned i, min_index, max_index;
-   double   min, max, total, var;
-   int      no_variance, sorted;
+   int      min_index, max_index;
+   double   var;
 
    /*--- Error check ---*/
    if(!CF_valid(ga_info)) UT_error("PL_stats: invalid ga_info");
@@ -3280,76 +5313,46 @@ PL_stats(
       return OK;
    }
 
-   /*--- Initialize stats ---*/
-   min         = pool->chrom[0]->fitness;
-   max         = pool->chrom[0]->fitness;
-   min_index   = 0;
-   max_index   = 0;
-   var         = 0.0;
-   total       = 0.0;
-   no_variance = TRUE;
-   sorted      = TRUE;
-
-   /*--- Collect statistics and find total fitness ---*/
-   for(i = 0; i < pool->size; i++) {
-
-      /*--- Error check ---*/
-      if(!CH_valid(pool->chrom[i])) UT_error("PL_stats: invalid chrom");
-
-      /*--- Comparative statistics ---*/
-      if(i != 0) {
-
-         /*--- Check for variance in fitness ---*/
-         if(no_variance && 
-            pool->chrom[i]->fitness != pool->chrom[i-1]->fitness)
-         {
-            no_variance = FALSE;
-         }
-
-         /*--- Check for not sorted ---*/
-         if(sorted && pool->minimize) {
-            if(pool->chrom[i]->fitness < pool->chrom[i-1]->fitness)
-               sorted = FALSE;
-         } else if(sorted) {
-            if(pool->chrom[i]->fitness > pool->chrom[i-1]->fitness)
-               sorted = FALSE;
-         }
-      }
-
-      /*--- Less than min? ---*/
-      if(pool->chrom[i]->fitness < min) {
-         min = pool->chrom[i]->fitness;
-         min_index = i;
-      }
-
-      /*--- Greater than max? ---*/
-      if(pool->chrom[i]->fitness > max) {
-         max = pool->chrom[i]->fitness;
-         max_index = i;
-      }
-
-      /*--- Update cum. values ---*/
-      total += pool->chrom[i]->fitness;
-      var   += (float)pool->chrom[i]->fitness * 
-               (float)pool->chrom[i]->fitness;
-
-      /*--- Make sure index is set ---*/
-      pool->chrom[i]->index = i;
+   /*--- Running statistics, from a full pass if the pool changed otherwise ---*/
+   if(pool->stat_epoch != pool->epoch || pool->stat_n != pool->size ||
+      pool->stat_updates > PL_STAT_PASS * (long)pool->size)
+      PL_stats_build(pool);
+#ifdef GA_CHECK_STATS
+   else
+      PL_stats_check(pool);
+#endif
+   PL_stats_fix(pool, FALSE);
+
+   /*--- Min and max at the ends when in order, else from the trees ---*/
+   if(pool->stat_unsorted == 0 && pool->minimize) {
+      min_index = 0;
+      max_index = PL_stats_first(pool, pool->size-1);
+   } else if(pool->stat_unsorted == 0) {
+      max_index = 0;
+      min_index = PL_stats_first(pool, pool->size-1);
+   } else {
+      PL_stats_fix(pool, TRUE);
+      min_index = pool->stat_min[1];
+      max_index = pool->stat_max[1];
    }
 
    /*--- Update pool statistics ---*/
-   pool->min = min;
-   pool->max = max;
-   pool->ave = total / pool->size;
+   pool->min = pool->chrom[min_index]->fitness;
+   pool->max = pool->chrom[max_index]->fitness;
+   pool->ave = pool->stat_mean;
    pool->min_index = min_index;
    pool->max_index = max_index;
    if(pool->minimize) pool->best_index = min_index;
    else               pool->best_index = max_index;
-   pool->total_fitness = total;
+   pool->total_fitness = pool->stat_mean * pool->size;
+
+   /*--- Already in PL_sort() order, no need to sort again ---*/
+   if(pool->stat_unsorted == 0 && pool->minimize == ga_info->minimize) 
+      pool->sort_epoch = pool->epoch;
 
    /*--- Variance and standard deviation ---*/
-   var = (var - (pool->ave * total)) / (pool->size - 1);
-   if(no_variance || var <= 0.0) {
+   var = pool->stat_m2 / (pool->size - 1);
+   if(pool->min == pool->max || var <= 0.0) {
       pool->var = 0.0;
       pool->dev = 0.0;
       ga_info->converged = TRUE;
@@ -3361,91 +5364,535 @@ PL_stats(
 }
 
 /*----------------------------------------------------------------------------
-| Update indices in the pool
+| Is the chrom after position p in a pool out of PL_sort() order?
 ----------------------------------------------------------------------------*/
-PL_index(   Pool_Ptr pool)
+static int PL_stats_bad(
+   Pool_Ptr pool,
+   int      p)
 {
-   int i;
+   if(pool->minimize)
+      return pool->chrom[p+1]->fitness < pool->chrom[p]->fitness;
+   else
+      return pool->chrom[p+1]->fitness > pool->chrom[p]->fitness;
+}
 
-   /*--- Error check ---*/
-   if(!PL_valid(pool)) UT_error("PL_index: invalid pool");
+/*----------------------------------------------------------------------------
+| Is pair p out of order and not left to PL_stats_fix()?
+----------------------------------------------------------------------------*/
+static int PL_stats_open(
+   Pool_Ptr pool,
+   int      p)
+{
+   if(p >= pool->stat_lo-1 && p <= pool->stat_hi) return 0;
+   return PL_stats_bad(pool, p);
+}
 
-   /*--- Set index for each chromosome ---*/
-   for(i=0; i<pool->size; i++)
-      pool->chrom[i]->index = i;
+/*----------------------------------------------------------------------------
+| Adjacent pairs out of order among those holding the chroms at i or j
+----------------------------------------------------------------------------*/
+static int PL_stats_pairs(
+   Pool_Ptr pool,
+   int      i, int j)
+{
+   int p, lo, hi, last, bad;
+
+   if(i < j) { lo = i; hi = j; } else { lo = j; hi = i; }
+   last = pool->size - 2;
+   bad  = 0;
+
+   /*--- Near each other: pairs lo-1 ... hi ---*/
+   if(hi - lo <= 1) {
+      for(p = lo > 0 ? lo-1 : 0; p <= hi && p <= last; p++) 
+         bad += PL_stats_open(pool, p);
+      return bad;
+   }
+
+   /*--- Apart: pairs lo-1, lo, hi-1, hi ---*/
+   if(lo > 0)     bad += PL_stats_open(pool, lo-1);
+   if(lo <= last) bad += PL_stats_open(pool, lo);
+   if(hi <= last+1) bad += PL_stats_open(pool, hi-1);
+   if(hi <= last) bad += PL_stats_open(pool, hi);
+   return bad;
 }
 
 /*----------------------------------------------------------------------------
-| Update ptf (percent of total fitness) for each chromosome
+| Winner of two chrom indices in the min (or max) tree, -1 is no chrom
+|
+| NOTE: On a tie the lower index, which is always a, wins, as in a scan
 ----------------------------------------------------------------------------*/
-PL_update_ptf(
-   GA_Info_Ptr ga_info,
-   Pool_Ptr    pool)
+static int PL_stats_win(
+   Pool_Ptr pool,
+   int      a, int b,
+   int      max)
 {
-   int i, sf_changed, all_positive;
+   if(a < 0) return b;
+   if(b < 0) return a;
+   if(max) 
+      return pool->chrom[b]->fitness > pool->chrom[a]->fitness ? b : a;
+   else
+      return pool->chrom[b]->fitness < pool->chrom[a]->fitness ? b : a;
+}
 
-   /*--- Error check ---*/
-   if(!CF_valid(ga_info)) UT_error("PL_update_ptf: invalid ga_info");
-   if(!PL_valid(pool)) UT_error("PL_update_ptf: invalid pool");
+/*----------------------------------------------------------------------------
+| Update the leaf of the chrom at i and its way up the min and max trees
+----------------------------------------------------------------------------*/
+static int PL_stats_leaf(
+   Pool_Ptr pool,
+   int      i)
+{
+   int k;
+
+   pool->chrom[i]->index = i;
+   k = pool->stat_leaves + i;
+   pool->stat_min[k] = pool->stat_max[k] = i;
+   for(k /= 2; k >= 1; k /= 2) {
+      pool->stat_min[k] = PL_stats_win(pool, pool->stat_min[2*k], 
+                                       pool->stat_min[2*k+1], FALSE);
+      pool->stat_max[k] = PL_stats_win(pool, pool->stat_max[2*k], 
+                                       pool->stat_max[2*k+1], TRUE);
+   }
 
-   /*--- Compute scale factor (to ensure positive fitness) ---*/
-   sf_changed = FALSE;
-   all_positive = TRUE;
-   for(i = 0; i < pool->size; i++) {
+   return OK;
+}
 
-      /*--- If scaled fitness not positive ---*/
-      if((pool->chrom[i]->fitness + ga_info->scale_factor) <= 0) {
+/*----------------------------------------------------------------------------
+| Before the chroms at i and j are swapped, leave them to PL_stats_fix():
+| the range of swapped chroms takes them in, and the adjacent pairs it
+| newly covers are taken out of the unsorted count.  FALSE if the trees 
+| have no leaf for them.
+|
+| NOTE: Bubbling a chrom k places down costs O(1) a swap, and O(k + log n)
+|       once in PL_stats_fix(), instead of O(log n) a swap.
+----------------------------------------------------------------------------*/
+static int PL_stats_cover(
+   Pool_Ptr pool,
+   int      i, int j)
+{
+   int p, lo, hi, last;
 
-         /*--- Adjust scale_factor so scaled fitness is 1.0 ---*/
-         ga_info->scale_factor += 
-            1.0 - (pool->chrom[i]->fitness + ga_info->scale_factor);
+   if(i >= pool->stat_leaves || j >= pool->stat_leaves) return FALSE;
 
-         /*--- The scale_factor has been changed ---*/
-         sf_changed = TRUE;
-      } 
+   lo   = i < j ? i : j;
+   hi   = i < j ? j : i;
+   last = pool->size - 2;
 
-      /*--- Make sure scale factor is still needed ---*/
-      if(pool->chrom[i]->fitness <= 0) all_positive = FALSE;
+   /*--- Only the pairs outside the old range ---*/
+   if(pool->stat_lo > pool->stat_hi) {
+      for(p = lo > 0 ? lo-1 : 0; p <= hi && p <= last; p++) 
+         pool->stat_unsorted -= PL_stats_bad(pool, p);
+   } else {
+      for(p = lo > 0 ? lo-1 : 0; p < pool->stat_lo-1; p++) 
+         pool->stat_unsorted -= PL_stats_bad(pool, p);
+      for(p = pool->stat_hi+1; p <= hi && p <= last; p++) 
+         pool->stat_unsorted -= PL_stats_bad(pool, p);
+      if(pool->stat_lo < lo) lo = pool->stat_lo;
+      if(pool->stat_hi > hi) hi = pool->stat_hi;
    }
 
-   /*--- Scale factor no longer needed ---*/
-   if(all_positive) {
-      if(ga_info->scale_factor > 0.0) sf_changed = TRUE;
-      ga_info->scale_factor = 0.0;
-   }
+   pool->stat_lo = lo;
+   pool->stat_hi = hi;
+   return TRUE;
+}
 
-   /*--- Report change in scale factor ---*/
-   if(sf_changed && 
-      ga_info->rp_type != RP_NONE && 
-      ga_info->rp_type != RP_MINIMAL) 
-   {
-      fprintf(ga_info->rp_fid,
-              "New scale factor = %G\n", 
-               ga_info->scale_factor);
+/*----------------------------------------------------------------------------
+| Index the chroms swapped since the last call and count their adjacent
+| pairs again, then (if trees) bring every leaf left so far up the min 
+| and max trees
+|
+| NOTE: A level at a time, so a range of k leaves costs O(k + log n); 
+|       PL_stats() leaves the trees be as long as the pool is in order.
+----------------------------------------------------------------------------*/
+int PL_stats_fix(
+   Pool_Ptr pool,
+   int      trees)
+{
+   int k, p, lo, hi;
+
+   /*--- Swapped chroms ---*/
+   if(pool->stat_lo <= pool->stat_hi) {
+      lo = pool->stat_lo;
+      hi = pool->stat_hi;
+      for(k = lo; k <= hi; k++) pool->chrom[k]->index = k;
+      pool->stat_lo = pool->stat_leaves;
+      pool->stat_hi = -1;
+      for(p = lo > 0 ? lo-1 : 0; p <= hi && p <= pool->size-2; p++) 
+         pool->stat_unsorted += PL_stats_bad(pool, p);
+
+      if(lo < pool->stat_tlo) pool->stat_tlo = lo;
+      if(hi > pool->stat_thi) pool->stat_thi = hi;
    }
 
-   /*--- Find total fitness ---*/
-   pool->total_fitness = 0;
-   for(i = 0; i < pool->size; i++) {
-      pool->total_fitness += pool->chrom[i]->fitness + ga_info->scale_factor;
+   /*--- Their leaves ---*/
+   if(!trees || pool->stat_tlo > pool->stat_thi) return OK;
+
+   lo = pool->stat_leaves + pool->stat_tlo;
+   hi = pool->stat_leaves + pool->stat_thi;
+   for(k = lo; k <= hi; k++)
+      pool->stat_min[k] = pool->stat_max[k] = k - pool->stat_leaves;
+   while(lo > 1) {
+      lo /= 2; hi /= 2;
+      for(k = lo; k <= hi; k++) {
+         pool->stat_min[k] = PL_stats_win(pool, pool->stat_min[2*k], 
+                                          pool->stat_min[2*k+1], FALSE);
+         pool->stat_max[k] = PL_stats_win(pool, pool->stat_max[2*k], 
+                                          pool->stat_max[2*k+1], TRUE);
+      }
    }
+   pool->stat_tlo = pool->stat_leaves;
+   pool->stat_thi = -1;
 
-   /*--- Update ptf for each chromosome (minimize) ---*/
-   if(ga_info->minimize) {
-      double new_total_fitness;
+   return OK;
+}
 
-      /*--- Compute new fitness and total_fitness ---*/
-      new_total_fitness = 0.0;
-      for(i = 0; i < pool->size; i++) {
+/*----------------------------------------------------------------------------
+| First chrom of an in order pool with the same fitness as the chrom at i
+----------------------------------------------------------------------------*/
+int PL_stats_first(
+   Pool_Ptr pool,
+   int      i)
+{
+   int lo, mid;
 
-         /*--- Failed scaling leads to divide by zero ---*/
-         if((pool->chrom[i]->fitness + ga_info->scale_factor) <= 0.0)
+   for(lo = 0; lo < i; ) {
+      mid = (lo + i) / 2;
+      if(pool->chrom[mid]->fitness == pool->chrom[i]->fitness) i = mid;
+      else lo = mid + 1;
+   }
+   return i;
+}
+
+/*----------------------------------------------------------------------------
+| Full pass over a pool for its running statistics
+|
+| NOTE: The mean and the sum of squared deviations from it are accumulated
+|       as by Welford, the min and max are kept in two trees with a leaf per
+|       chrom pointer, so PL_stats_in() updates them in O(log n).
+----------------------------------------------------------------------------*/
+int PL_stats_build(
+   Pool_Ptr pool)
+{
+   int    i, k, leaves;
+   double d, f;
+
+   /*--- Room for a leaf per chrom pointer ---*/
+   for(leaves = 1; leaves < pool->max_size; leaves *= 2) ;
+   if(leaves != pool->stat_leaves) {
+      pool->stat_min = (int *)realloc(pool->stat_min, 2 * leaves * sizeof(int));
+      pool->stat_max = (int *)realloc(pool->stat_max, 2 * leaves * sizeof(int));
+      if(pool->stat_min == NULL || pool->stat_max == NULL) 
+         UT_error("PL_stats_build: tree alloc failed");
+      pool->stat_leaves = leaves;
+   }
+
+   /*--- Mean, squares and order ---*/
+   pool->stat_n        = 0;
+   pool->stat_mean     = 0.0;
+   pool->stat_m2       = 0.0;
+   pool->stat_unsorted = 0;
+   for(i = 0; i < pool->size; i++) {
+
+      /*--- Error check ---*/
+      if(!CH_valid(pool->chrom[i])) UT_error("PL_stats: invalid chrom");
+
+      /*--- Make sure index is set ---*/
+      pool->chrom[i]->index = i;
+
+      f = pool->chrom[i]->fitness;
+      d = f - pool->stat_mean;
+      pool->stat_n++;
+      pool->stat_mean += d / pool->stat_n;
+      pool->stat_m2   += d * (f - pool->stat_mean);
+      if(i > 0) pool->stat_unsorted += PL_stats_bad(pool, i-1);
+   }
+
+   /*--- Min and max trees, leaves up ---*/
+   for(i = 0; i < leaves; i++)
+      pool->stat_min[leaves+i] = pool->stat_max[leaves+i] = 
+         i < pool->size ? i : -1;
+   for(k = leaves-1; k >= 1; k--) {
+      pool->stat_min[k] = PL_stats_win(pool, pool->stat_min[2*k], 
+                                       pool->stat_min[2*k+1], FALSE);
+      pool->stat_max[k] = PL_stats_win(pool, pool->stat_max[2*k], 
+                                       pool->stat_max[2*k+1], TRUE);
+   }
+
+   pool->stat_lo      = pool->stat_tlo = leaves;
+   pool->stat_hi      = pool->stat_thi = -1;
+   pool->stat_updates = 0;
+   pool->stat_epoch   = pool->epoch;
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Take the chroms at i and j (may be the same) out of the running stats,
+| before they are replaced or moved
+----------------------------------------------------------------------------*/
+int PL_stats_out(
+   Pool_Ptr pool,
+   int      i, int j)
+{
+   int    k;
+   double d, f;
+
+   pool->stat_unsorted -= PL_stats_pairs(pool, i, j);
+
+   for(k = i; ; k = j) {
+      f = pool->chrom[k]->fitness;
+      if(--pool->stat_n == 0) {
+         pool->stat_mean = 0.0;
+         pool->stat_m2   = 0.0;
+      } else {
+         d = f - pool->stat_mean;
+         pool->stat_mean -= d / pool->stat_n;
+         pool->stat_m2   -= d * (f - pool->stat_mean);
+         if(pool->stat_m2 < 0.0) pool->stat_m2 = 0.0;
+      }
+      if(k == j) break;
+   }
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Put the chroms now at i and j (may be the same) in the running stats
+|
+| NOTE: FALSE if the trees have no leaf for them, the stats are then left
+|       to the next full pass
+----------------------------------------------------------------------------*/
+int PL_stats_in(
+   Pool_Ptr pool,
+   int      i, int j)
+{
+   int    k;
+   double d, f;
+
+   if(i >= pool->stat_leaves || j >= pool->stat_leaves) return FALSE;
+
+   for(k = i; ; k = j) {
+      f = pool->chrom[k]->fitness;
+      d = f - pool->stat_mean;
+      pool->stat_n++;
+      pool->stat_mean += d / pool->stat_n;
+      pool->stat_m2   += d * (f - pool->stat_mean);
+      PL_stats_leaf(pool, k);
+      if(k == j) break;
+   }
+
+   pool->stat_unsorted += PL_stats_pairs(pool, i, j);
+   pool->stat_updates++;
+
+   return TRUE;
+}
+
+/*----------------------------------------------------------------------------
+| Compare the running stats of a pool with a full pass (GA_CHECK_STATS)
+----------------------------------------------------------------------------*/
+int PL_stats_check(
+   Pool_Ptr pool)
+{
+   int    min_index, max_index, unsorted;
+   double mean, m2;
+
+   PL_stats_fix(pool, TRUE);
+   min_index = pool->stat_min[1];
+   max_index = pool->stat_max[1];
+   unsorted  = pool->stat_unsorted;
+   mean      = pool->stat_mean;
+   m2        = pool->stat_m2;
+
+   PL_stats_build(pool);
+
+   if(min_index != pool->stat_min[1] || max_index != pool->stat_max[1] ||
+      unsorted != pool->stat_unsorted ||
+      fabs(mean - pool->stat_mean) > 1e-9 * (1.0 + fabs(pool->stat_mean)) ||
+      fabs(m2 - pool->stat_m2) > 1e-6 * (1.0 + pool->stat_m2))
+      UT_warn("PL_stats_check: running statistics differ from a full pass");
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Bring the min and max trees of a pool up to date, from a full pass if 
+| the running stats are not live
+----------------------------------------------------------------------------*/
+static int PL_stats_trees(
+   Pool_Ptr pool)
+{
+   if(pool->stat_epoch != pool->epoch || pool->stat_n != pool->size)
+      PL_stats_build(pool);
+   PL_stats_fix(pool, TRUE);
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Index of the weakest chrom of a pool, the last one on a tie
+|
+| NOTE: The same chrom as a scan with CH_cmp() >= 0, found in O(log n) by
+|       going down the max (min) tree to the right-most leaf that has the
+|       root's fitness.
+----------------------------------------------------------------------------*/
+int PL_weakest(
+   GA_Info_Ptr ga_info,
+   Pool_Ptr    pool)
+{
+   int    *tree, k, w;
+   double f;
+
+   /*--- Error check ---*/
+   if(!CF_valid(ga_info)) UT_error("PL_weakest: invalid ga_info");
+   if(!PL_valid(pool)) UT_error("PL_weakest: invalid pool");
+   if(pool->size <= 0) UT_error("PL_weakest: empty pool");
+
+   PL_stats_trees(pool);
+   tree = ga_info->minimize ? pool->stat_max : pool->stat_min;
+
+   f = pool->chrom[tree[1]]->fitness;
+   for(k = 1; k < pool->stat_leaves; ) {
+      w = tree[2*k+1];
+      if(w >= 0 && pool->chrom[w]->fitness == f) k = 2*k+1;
+      else k = 2*k;
+   }
+   return k - pool->stat_leaves;
+}
+
+/*----------------------------------------------------------------------------
+| Index of the first chrom of a pool weaker than chrom, -1 if none is
+|
+| NOTE: O(log n), going down the max (min) tree to the left-most leaf 
+|       whose subtree holds a weaker chrom.
+----------------------------------------------------------------------------*/
+int PL_first_weaker(
+   GA_Info_Ptr ga_info,
+   Pool_Ptr    pool,
+   Chrom_Ptr   chrom)
+{
+   int *tree, k, w;
+
+   /*--- Error check ---*/
+   if(!CF_valid(ga_info)) UT_error("PL_first_weaker: invalid ga_info");
+   if(!PL_valid(pool)) UT_error("PL_first_weaker: invalid pool");
+   if(!CH_valid(chrom)) UT_error("PL_first_weaker: invalid chrom");
+   if(pool->size <= 0) return -1;
+
+   PL_stats_trees(pool);
+   tree = ga_info->minimize ? pool->stat_max : pool->stat_min;
+
+   if(CH_cmp(ga_info, pool->chrom[tree[1]], chrom) <= 0) return -1;
+   for(k = 1; k < pool->stat_leaves; ) {
+      w = tree[2*k];
+      if(w >= 0 && CH_cmp(ga_info, pool->chrom[w], chrom) > 0) k = 2*k;
+      else k = 2*k+1;
+   }
+   return k - pool->stat_leaves;
+}
+
+/*----------------------------------------------------------------------------
+| Is a pool in PL_sort() order?  Only TRUE if known without a pass.
+----------------------------------------------------------------------------*/
+int PL_in_order(
+   GA_Info_Ptr ga_info,
+   Pool_Ptr    pool)
+{
+   if(pool->sort_epoch == pool->epoch) return TRUE;
+   if(pool->stat_epoch != pool->epoch || pool->minimize != ga_info->minimize)
+      return FALSE;
+
+   PL_stats_fix(pool, FALSE);
+   return pool->stat_unsorted == 0;
+}
+
+/*----------------------------------------------------------------------------
+| Update indices in the pool
+----------------------------------------------------------------------------*/
+PL_index(   Pool_Ptr pool)
+{
+   int i;
+
+   /*--- Error check ---*/
+   if(!PL_valid(pool)) UT_error("PL_index: invalid pool");
+
+   /*--- Set index for each chromosome ---*/
+   for(i=0; i<pool->size; i++)
+      pool->chrom[i]->index = i;
+}
+
+/*----------------------------------------------------------------------------
+| Update ptf (percent of total fitness) for each chromosome
+----------------------------------------------------------------------------*/
+PL_update_ptf(
+   GA_Info_Ptr ga_info,
+   Pool_Ptr    pool)
+{
+   int    i, sf_changed, all_positive;
+   double *fit;
+
+   /*--- Error check ---*/
+   if(!CF_valid(ga_info)) UT_error("PL_update_ptf: invalid ga_info");
+   if(!PL_valid(pool)) UT_error("PL_update_ptf: invalid pool");
+
+   /*--- Scans below stream through the fitness array ---*/
+   fit = PL_fitness(pool);
+
+   /*--- Compute scale factor (to ensure positive fitness) ---*/
+   sf_changed = FALSE;
+   all_positive = TRUE;
+   for(i = 0; i < pool->size; i++) {
+
+      /*--- If scaled fitness not positive ---*/
+      if((fit[i] + ga_info->scale_factor) <= 0) {
+
+         /*--- Adjust scale_factor so scaled fitness is 1.0 ---*/
+         ga_info->scale_factor += 
+            1.0 - (fit[i] + ga_info->scale_factor);
+
+         /*--- The scale_factor has been changed ---*/
+         sf_changed = TRUE;
+      } 
+
+      /*--- Make sure scale factor is still needed ---*/
+      if(fit[i] <= 0) all_positive = FALSE;
+   }
+
+   /*--- Scale factor no longer needed ---*/
+   if(all_positive) {
+      if(ga_info->scale_factor > 0.0) sf_changed = TRUE;
+      ga_info->scale_factor = 0.0;
+   }
+
+   /*--- Report change in scale factor ---*/
+   if(sf_changed && 
+      ga_info->rp_type != RP_NONE && 
+      ga_info->rp_type != RP_MINIMAL) 
+   {
+      fprintf(ga_info->rp_fid,
+              "New scale factor = %G\n", 
+               ga_info->scale_factor);
+   }
+
+   /*--- Find total fitness ---*/
+   pool->total_fitness = 0;
+   for(i = 0; i < pool->size; i++) {
+      pool->total_fitness += fit[i] + ga_info->scale_factor;
+   }
+
+   /*--- Update ptf for each chromosome (minimize) ---*/
+   if(ga_info->minimize) {
+      double new_total_fitness;
+
+      /*--- Compute new fitness and total_fitness ---*/
+      new_total_fitness = 0.0;
+      for(i = 0; i < pool->size; i++) {
+
+         /*--- Failed scaling leads to divide by zero ---*/
+         if((fit[i] + ga_info->scale_factor) <= 0.0)
             UT_error("PL_update_ptf: fitness + scale <= 0.0");
 
          /*--- Save new fitness in ptf ---*/
          pool->chrom[i]->ptf = 
             pool->total_fitness / 
-            (pool->chrom[i]->fitness + ga_info->scale_factor);
+            (fit[i] + ga_info->scale_factor);
 
          /*--- New total fitness based on new ptf ---*/
          new_total_fitness += pool->chrom[i]->ptf;
@@ -3474,7 +5921,7 @@ PL_update_ptf(
 
          /*--- New ptf ---*/
          pool->chrom[i]->ptf = 
-            ((pool->chrom[i]->fitness + ga_info->scale_factor) / 
+            ((fit[i] + ga_info->scale_factor) / 
             pool->total_fitness) * 100.0;
       }
    }
@@ -3482,6 +5929,31 @@ PL_update_ptf(
    return OK;
 }
 
+/*----------------------------------------------------------------------------
+| Fitness of every chrom in a pool, as an array
+|
+| NOTE: The array is gathered from the chroms once per pool epoch, so scans
+|       that would chase a pointer per chrom (several times over) read
+|       contiguous memory instead.  Do not keep it across a PL_touch().
+----------------------------------------------------------------------------*/
+double *PL_fitness(
+   Pool_Ptr pool)
+{
+   int i;
+
+   /*--- Error check ---*/
+   if(!PL_valid(pool)) UT_error("PL_fitness: invalid pool");
+
+   /*--- Gather if the pool changed ---*/
+   if(pool->fit_epoch != pool->epoch) {
+      for(i = 0; i < pool->size; i++)
+         pool->fit[i] = pool->chrom[i]->fitness;
+      pool->fit_epoch = pool->epoch;
+   }
+
+   return pool->fit;
+}
+
 /*============================================================================
 |                            Pool manipulation
 ============================================================================*/
@@ -3514,13 +5986,66 @@ PL_append(
    Chrom_Ptr chrom,
    int       make_copy)
 {
+   int live;
+
    /*--- Error check ---*/
    if(!PL_valid(pool)) UT_error("PL_append: invalid pool");
    if(!CH_valid(chrom)) UT_error("PL_append: invalid chrom");
 
    /*--- Append = insert at end of pool ---*/
    PL_insert(pool, (int)pool->size, chrom, make_copy);
+   live = (pool->stat_epoch == pool->epoch);
+   ++(pool->size); 
+   PL_touch(pool);
+
+   /*--- Running stats take the new chrom ---*/
+   if(live && PL_stats_in(pool, pool->size-1, pool->size-1)) 
+      pool->stat_epoch = pool->epoch;
+}
+
+/*----------------------------------------------------------------------------
+| Append a chromosome without copying it: the pool takes *chrom and hands
+| back the spare chrom left in the slot past its end (or a fresh one)
+----------------------------------------------------------------------------*/
+int PL_append_move(
+   Pool_Ptr  pool,
+   Chrom_Ptr *chrom)
+{
+   Chrom_Ptr spare;
+   int       live;
+
+   /*--- Error check ---*/
+   if(!PL_valid(pool)) UT_error("PL_append_move: invalid pool");
+   if(chrom == NULL || !CH_valid(*chrom)) 
+      UT_error("PL_append_move: invalid chrom");
+
+   /*--- Realloc for more space ---*/
+   if(pool->size == pool->max_size) 
+      PL_resize(pool, pool->max_size + PL_ALLOC_SIZE);
+
+   /*--- The spare must be able to take the place of the chrom ---*/
+   spare = pool->chrom[pool->size];
+   if(CH_valid(spare) && (spare->length != (*chrom)->length ||
+                          CH_packed(spare) != CH_packed(*chrom))) {
+      CH_free(spare);
+      spare = NULL;
+   }
+   if(!CH_valid(spare))
+      spare = PL_new_chrom(pool, (*chrom)->length, 
+                           CH_packed(*chrom) ? DT_PACKED_BIT : DT_BIT);
+
+   /*--- Swap ownership ---*/
+   live = (pool->stat_epoch == pool->epoch);
+   pool->chrom[pool->size] = *chrom;
+   *chrom = spare;
    ++(pool->size); 
+   PL_touch(pool);
+
+   /*--- Running stats take the new chrom ---*/
+   if(live && PL_stats_in(pool, pool->size-1, pool->size-1)) 
+      pool->stat_epoch = pool->epoch;
+
+   return OK;
 }
 
 /*----------------------------------------------------------------------------
@@ -3532,6 +6057,8 @@ PL_insert(
    Chrom_Ptr chrom,
    int       make_copy)
 {
+   int live, member;
+
    /*--- Error check ---*/
    if(!PL_valid(pool)) UT_error("PL_insert: invalid pool");
    if(!CH_valid(chrom)) UT_error("PL_insert: invalid chrom");
@@ -3541,21 +6068,36 @@ PL_insert(
    /*--- Realloc for more space ---*/
    if(index == pool->max_size) 
       PL_resize(pool, pool->max_size + PL_ALLOC_SIZE);
+
+   /*--- Running stats let go of a chrom being replaced ---*/
+   live   = (pool->stat_epoch == pool->epoch);
+   member = (index < pool->size);
+   if(live && member) PL_stats_out(pool, index, index);
  
    /*--- Insert the chromosome ---*/
+   PL_touch(pool);
    if(make_copy) {
       if(!CH_valid(pool->chrom[index])) 
-         pool->chrom[index] = CH_alloc(chrom->length);
+         pool->chrom[index] = PL_new_chrom(pool, chrom->length, 
+                              CH_packed(chrom) ? DT_PACKED_BIT : DT_BIT);
       CH_copy(chrom, pool->chrom[index]);
    } else {
       if(CH_valid(pool->chrom[index])) 
          PL_remove(pool, index);
       pool->chrom[index] = chrom;
    }
+
+   /*--- ... and take its replacement ---*/
+   if(live && (!member || PL_stats_in(pool, index, index)))
+      pool->stat_epoch = pool->epoch;
 }
  
 /*----------------------------------------------------------------------------
 | Remove a chromosome from the pool
+|
+| NOTE: Removing one of the first size chroms leaves a hole, to be filled by
+|       PL_insert() (which keeps the running stats up to date) before the
+|       next PL_stats(); otherwise PL_stats() makes a full pass.
 ----------------------------------------------------------------------------*/
 PL_remove(
    Pool_Ptr pool,
@@ -3568,6 +6110,7 @@ PL_remove(
 
    if(CH_valid(pool->chrom[index])) CH_free(pool->chrom[index]);
    pool->chrom[index] = NULL;
+   PL_touch(pool);
 }
 
 /*----------------------------------------------------------------------------
@@ -3587,6 +6130,7 @@ PL_move(
    if(CH_valid(pool->chrom[idx_dst])) PL_remove(pool, idx_dst);
    pool->chrom[idx_dst] = pool->chrom[idx_src];
    pool->chrom[idx_src] = NULL;
+   PL_touch(pool);
 }
 
 /*----------------------------------------------------------------------------
@@ -3597,6 +6141,7 @@ PL_swap(
    int      idx1, int idx2)
 {
    Chrom_Ptr tmp;
+   int       live;
 
    /*--- Error check ---*/
    if(!PL_valid(pool)) UT_error("PL_swap: invalid pool");
@@ -3604,10 +6149,82 @@ PL_swap(
       UT_error("PL_swap: invalid idx1");
    if(idx2 < 0 || idx2 >= pool->max_size) 
       UT_error("PL_swap: invalid idx2");
+
+   /*--- Running stats follow two chroms of the pool (same mean, squares) ---*/
+   live = pool->stat_epoch == pool->epoch && 
+          idx1 < pool->size && idx2 < pool->size &&
+          PL_stats_cover(pool, idx1, idx2);
  
    tmp               = pool->chrom[idx1];
    pool->chrom[idx1] = pool->chrom[idx2];
    pool->chrom[idx2] = tmp;
+   PL_touch(pool);
+
+   if(live) pool->stat_epoch = pool->epoch;
+}
+
+/*----------------------------------------------------------------------------
+| Move the chrom at idx_src to idx_dst, shifting those in between by one
+|
+| NOTE: Same pool as a run of PL_swap() of neighbours, as one memmove().
+|       Only the adjacent pairs at the ends of the shifted run change, the
+|       running stats note those and leave the min and max trees (and the 
+|       indices) of the run to PL_stats_fix().
+----------------------------------------------------------------------------*/
+int PL_shift(
+   Pool_Ptr pool,
+   int      idx_src, int idx_dst)
+{
+   Chrom_Ptr tmp;
+   int       live, lo, hi, p[3], k;
+
+   /*--- Error check ---*/
+   if(!PL_valid(pool)) UT_error("PL_shift: invalid pool");
+   if(idx_src < 0 || idx_src >= pool->size) 
+      UT_error("PL_shift: invalid idx_src");
+   if(idx_dst < 0 || idx_dst >= pool->size) 
+      UT_error("PL_shift: invalid idx_dst");
+   if(idx_src == idx_dst) return OK;
+
+   lo = idx_src < idx_dst ? idx_src : idx_dst;
+   hi = idx_src < idx_dst ? idx_dst : idx_src;
+
+   /*--- Pairs at the ends of the run (before and after the shift) ---*/
+   if(idx_src > idx_dst) { p[0] = lo-1; p[1] = hi-1; p[2] = hi; }
+   else                  { p[0] = lo-1; p[1] = lo;   p[2] = hi; }
+
+   live = pool->stat_epoch == pool->epoch && hi < pool->stat_leaves;
+   if(live) {
+      PL_stats_fix(pool, FALSE);
+      for(k = 0; k < 3; k++) 
+         if(p[k] >= 0 && p[k] <= pool->size-2) 
+            pool->stat_unsorted -= PL_stats_bad(pool, p[k]);
+   }
+
+   /*--- Shift ---*/
+   tmp = pool->chrom[idx_src];
+   if(idx_src > idx_dst) 
+      memmove(&pool->chrom[lo+1], &pool->chrom[lo], 
+              (hi - lo) * sizeof(Chrom_Ptr));
+   else
+      memmove(&pool->chrom[lo], &pool->chrom[lo+1], 
+              (hi - lo) * sizeof(Chrom_Ptr));
+   pool->chrom[idx_dst] = tmp;
+   PL_touch(pool);
+
+   if(live) {
+      if(idx_src > idx_dst) { p[1] = lo; }
+      else                  { p[1] = hi-1; }
+      for(k = 0; k < 3; k++) 
+         if(p[k] >= 0 && p[k] <= pool->size-2) 
+            pool->stat_unsorted += PL_stats_bad(pool, p[k]);
+      for(k = lo; k <= hi; k++) pool->chrom[k]->index = k;
+      if(lo < pool->stat_tlo) pool->stat_tlo = lo;
+      if(hi > pool->stat_thi) pool->stat_thi = hi;
+      pool->stat_epoch = pool->epoch;
+   }
+
+   return OK;
 }
 
 /*----------------------------------------------------------------------------
@@ -3658,6 +6275,54 @@ PL_sort(
 
    /*--- Pool is now sorted ---*/
    pool->sorted = TRUE;
+   pool->sort_epoch = PL_touch(pool);
+}
+
+/*----------------------------------------------------------------------------
+| Give a pool a slab of chrom slots, one per chrom pointer
+|
+| NOTE: A slab of another length or datatype is released (once its chroms
+|       are freed) and replaced
+----------------------------------------------------------------------------*/
+int PL_slab(
+   Pool_Ptr pool,
+   int      length,
+   int      datatype,
+   int      huge)
+{
+   CH_Slab_Ptr slab = pool->slab;
+
+   /*--- Error check ---*/
+   if(!PL_valid(pool)) UT_error("PL_slab: invalid pool");
+
+   /*--- Current slab will do ---*/
+   if(slab != NULL && slab->length == length && 
+      slab->packed == (datatype == DT_PACKED_BIT) &&
+      slab->num_slots >= pool->max_size)
+      return OK;
+
+   if(slab != NULL) CH_slab_free(slab);
+   pool->slab = CH_slab_alloc(pool->max_size, length, datatype, huge);
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| A fresh chrom for a pool: from its slab if it fits, else from the heap
+----------------------------------------------------------------------------*/
+Chrom_Ptr PL_new_chrom(
+   Pool_Ptr pool,
+   int      length,
+   int      datatype)
+{
+   Chrom_Ptr chrom;
+
+   if(pool->slab != NULL && pool->slab->length == length &&
+      pool->slab->packed == (datatype == DT_PACKED_BIT) &&
+      (chrom = CH_slab_get(pool->slab)) != NULL)
+      return chrom;
+
+   return CH_alloc_type(length, datatype);
 }
 /*============================================================================
 | (c) Copyright Arthur L. Corcoran, 1992, 1993.  All rights reserved.
@@ -3678,6 +6343,7 @@ PL_sort(
 |    RE_select()  - select replacement method by name
 |    RE_name()    - get name of current crossover function
 |    RE_fun()     - setup and perform current crossover operator
+|    RE_move()    - same, handing the children over to the pool if possible
 |    
 | Utility
 |    RE_pick_best() - pick the best two out of four chromosomes
@@ -3751,9 +6417,43 @@ RE_fun(
    ga_info->RE_fun(ga_info, pool, p1, p2, c1, c2);
 }
 
-/*============================================================================
-|                             Replacement Methods
-============================================================================*/
+/*----------------------------------------------------------------------------
+| Replacement interface, children passed by reference
+|
+| NOTE: Appending needs no copy of the children, they are handed over to the
+|       pool and *c1, *c2 come back as spare chroms of the same kind. Other
+|       methods copy what they keep and leave *c1, *c2 alone.
+----------------------------------------------------------------------------*/
+int RE_move(
+   GA_Info_Ptr    ga_info,
+   Pool_Ptr       pool,
+   Chrom_Ptr      p1, Chrom_Ptr p2,Chrom_Ptr *c1,Chrom_Ptr *c2)
+{
+   /*--- Error checking ---*/
+   if(c1 == NULL) UT_error("RE_move: invalid c1");
+   if(c2 == NULL) UT_error("RE_move: invalid c2");
+
+   /*--- Copying methods ---*/
+   if(ga_info == NULL || ga_info->RE_fun != RE_append)
+      return RE_fun(ga_info, pool, p1, p2, *c1, *c2);
+
+   /*--- Error checking, as in RE_fun() and RE_append() ---*/
+   if(!PL_valid(pool)) UT_error("RE_move: invalid pool");
+   if(!CH_valid(p1)) UT_error("RE_move: invalid p1");
+   if(!CH_valid(p2)) UT_error("RE_move: invalid p2");
+
+   if(ga_info->elitist)
+      RE_pick_best(ga_info, p1, p2, *c1, *c2);
+
+   PL_append_move(pool, c1);
+   PL_append_move(pool, c2);
+
+   return OK;
+}
+
+/*============================================================================
+|                             Replacement Methods
+============================================================================*/
 /*----------------------------------------------------------------------------
 | Append children to pool
 ----------------------------------------------------------------------------*/
@@ -3833,18 +6533,12 @@ RE_first_weaker(GA_Info_Ptr    ga_info,
    /*--- PATCH 1 END ---*/
 
    /*--- Insert c1 ---*/
-   for(i=0; i<pool->size; i++) 
-      if(CH_cmp(ga_info, pool->chrom[i], c1) > 0) {
-         PL_insert(pool, i, c1, TRUE);
-         break;
-      }
+   i = PL_first_weaker(ga_info, pool, c1);
+   if(i >= 0) PL_insert(pool, i, c1, TRUE);
 
    /*--- Insert c2 ---*/
-   for(i=0; i<pool->size; i++) 
-      if(CH_cmp(ga_info, pool->chrom[i], c2) > 0) {
-         PL_insert(pool, i, c2, TRUE);
-         break;
-      }
+   i = PL_first_weaker(ga_info, pool, c2);
+   if(i >= 0) PL_insert(pool, i, c2, TRUE);
 }
 
 /*----------------------------------------------------------------------------
@@ -3854,8 +6548,7 @@ RE_weakest(GA_Info_Ptr    ga_info,
    Pool_Ptr       pool,
    Chrom_Ptr      p1, Chrom_Ptr p2,Chrom_Ptr c1,Chrom_Ptr c2)
 {
-   Chrom_Ptr weakest;
-   int       i, index;
+   int       index;
 
    /*--- Error check ---*/
    if(!CF_valid(ga_info)) UT_error("RE_weakest: invalid ga_info");
@@ -3875,27 +6568,13 @@ RE_weakest(GA_Info_Ptr    ga_info,
    /*--- PATCH 1 END ---*/
 
    /*--- Insert c1 ---*/
-   weakest = pool->chrom[0];
-   index = 0;
-   for(i=0; i<pool->size; i++) {
-      if(CH_cmp(ga_info, pool->chrom[i], weakest) >= 0) {
-         weakest = pool->chrom[i];
-         index = i;
-      }
-   }
-   if(CH_cmp(ga_info, weakest, c1) >= 0)
+   index = PL_weakest(ga_info, pool);
+   if(CH_cmp(ga_info, pool->chrom[index], c1) >= 0)
       PL_insert(pool, index, c1, TRUE);
 
    /*--- Insert c2 ---*/
-   weakest = pool->chrom[0];
-   index = 0;
-   for(i=0; i<pool->size; i++) {
-      if(CH_cmp(ga_info, pool->chrom[i], weakest) >= 0) {
-         weakest = pool->chrom[i];
-         index = i;
-      }
-   }
-   if(CH_cmp(ga_info, weakest, c2) >= 0)
+   index = PL_weakest(ga_info, pool);
+   if(CH_cmp(ga_info, pool->chrom[index], c2) >= 0)
       PL_insert(pool, index, c2, TRUE);
 }
 
@@ -3910,21 +6589,33 @@ RE_do_by_rank(
    Pool_Ptr       pool,
    Chrom_Ptr      chrom)
 {
-   int i, cmp;
+   int i, in_order;
    int min, max, med;
 
    /*--- Failure ---*/
    if(CH_cmp(ga_info, pool->chrom[pool->size-1], chrom) <= 0) return OK;
 
    /*--- Take place of last chrom ---*/
+   in_order = PL_in_order(ga_info, pool);
    PL_insert(pool, pool->size-1, chrom, TRUE);
 
-   /*--- Bubble new chrom into position ---*/
-   for(i=pool->size-1; i > 0; i--) {
-      cmp = CH_cmp(ga_info, pool->chrom[i-1], pool->chrom[i]);
-      if(cmp <= 0) break;
-      PL_swap(pool, i-1, i);
+   /*--- Bubble new chrom up past the weaker chroms before it ---*/
+   if(in_order) {
+
+      /*--- ... in a sorted pool these are all from the first weaker on ---*/
+      min = 0;
+      max = pool->size-1;
+      while(min < max) {
+         med = (min + max) / 2;
+         if(CH_cmp(ga_info, pool->chrom[med], chrom) > 0) max = med;
+         else min = med + 1;
+      }
+      i = min;
+   } else {
+      for(i=pool->size-1; i > 0; i--) 
+         if(CH_cmp(ga_info, pool->chrom[i-1], chrom) <= 0) break;
    }
+   PL_shift(pool, pool->size-1, i);
 
    return OK;
 }
@@ -4058,10 +6749,25 @@ RP_final( GA_Info_Ptr    ga_info)
               "\nThe specified number of iterations has been reached.\n");
    }
 
+   /*--- Evaluation statistics ---*/
+   fprintf(ga_info->rp_fid, "Evaluations: %ld (%ld delta, %ld skipped)\n", 
+           ga_info->tot_eval, ga_info->tot_delta, ga_info->tot_skip);
+   if(ga_info->LS_fun != NULL)
+      fprintf(ga_info->rp_fid, "Local Searches: %ld\n", ga_info->tot_ls);
+   fprintf(ga_info->rp_fid, "Genes: %ld bytes copied (%ld per trial)\n",
+           ga_info->tot_copy, 
+           ga_info->tot_trial > 0 ? ga_info->tot_copy / ga_info->tot_trial : 0L);
+   fprintf(ga_info->rp_fid, "Validation: %ld chroms verified, %ld skipped\n",
+           ga_info->tot_verify, ga_info->tot_unverified);
+   if(ga_info->cache_size > 0)
+      fprintf(ga_info->rp_fid, 
+              "Fitness Cache: %ld hits, %ld misses, %ld evictions\n",
+              ga_info->cache_hit, ga_info->cache_miss, ga_info->cache_evict);
+
    /*--- Print best ---*/
    fprintf(ga_info->rp_fid,"\nBest: ");
    for(i = 0; i < ga_info->best->length; i++) {
-      fprintf(ga_info->rp_fid,"%G ", ga_info->best->gene[i]);
+      fprintf(ga_info->rp_fid,"%G ", CH_gene(ga_info->best, i));
       if(i % 20 == 19 && i+1 < ga_info->best->length) 
          fprintf(ga_info->rp_fid,"\n      ");
    }
@@ -4135,7 +6841,7 @@ RP_short(GA_Info_Ptr    ga_info,
       /*--- Print best ---*/
       fprintf(ga_info->rp_fid,"\nBest: ");
       for(i = 0; i < ga_info->best->length; i++) {
-         fprintf(ga_info->rp_fid,"%G ", ga_info->best->gene[i]);
+         fprintf(ga_info->rp_fid,"%G ", CH_gene(ga_info->best, i));
          if(i % 20 == 19 && i+1 < ga_info->best->length) 
             fprintf(ga_info->rp_fid,"\n      ");
       }
@@ -4183,7 +6889,7 @@ RP_long(GA_Info_Ptr    ga_info,
         pool->chrom[i]->xp1 + 1, pool->chrom[i]->xp2 + 1, 
         pool->chrom[i]->fitness);
      for(j = 0; j < pool->chrom[i]->length; j++) {
-        fprintf(ga_info->rp_fid,"%G ", pool->chrom[i]->gene[j]);
+        fprintf(ga_info->rp_fid,"%G ", CH_gene(pool->chrom[i], j));
         if(j % 15 == 14 && j+1 < pool->chrom[i]->length) 
            fprintf(ga_info->rp_fid,"\n                                  ");
      }
@@ -4199,7 +6905,7 @@ RP_long(GA_Info_Ptr    ga_info,
    /*--- Print best ---*/
    fprintf(ga_info->rp_fid,"\nBest: ");
    for(i = 0; i < ga_info->best->length; i++) {
-      fprintf(ga_info->rp_fid,"%G ", ga_info->best->gene[i]);
+      fprintf(ga_info->rp_fid,"%G ", CH_gene(ga_info->best, i));
       if(i % 20 == 19 && i+1 < ga_info->best->length) 
          fprintf(ga_info->rp_fid,"\n      ");
    }
@@ -4222,9 +6928,12 @@ RP_long(GA_Info_Ptr    ga_info,
 | Operators
 |    SE_uniform_random()  - just pick one
 |    SE_roulette()        - standard roulette
-|       SE_max_roulette() - helper for roulette (maximizing)
-|       SE_min_roulette() - helper for roulette (minimizing)
+|       SE_wheel()        - helper for roulette (build the wheel)
+|       SE_spin()         - helper for roulette (spin the wheel)
+|    SE_sus()             - stochastic universal sampling
+|    SE_tournament()      - best of tn_size picked at random
 |    SE_rank_biased()     - standard linear bias 
+|       SE_rank_table()   - helper for rank biased (alias table)
 |
 | Interface
 |    SE_table[]   - used in selection of selection method
@@ -4232,6 +6941,7 @@ RP_long(GA_Info_Ptr    ga_info,
 |    SE_select()  - select selection method by name
 |    SE_name()    - get name of current selection method
 |    SE_fun()     - setup and perform selection operator
+|    SE_batch()   - draw a batch of selections at once (SUS only)
 ============================================================================*/
 
 /*============================================================================
@@ -4245,6 +6955,8 @@ FN_Table_Type SE_table[] = {
    { "uniform_random", SE_uniform_random },
    { "roulette",       SE_roulette       },
    { "rank_biased",    SE_rank_biased    },
+   { "sus",            SE_sus            },
+   { "tournament",     SE_tournament     },
    { NULL,             NULL              }
 };
 
@@ -4299,6 +7011,65 @@ Chrom_Ptr SE_fun(
    return pool->chrom[idx];
 }
 
+/*----------------------------------------------------------------------------
+| Draw the next n selections from pool at once
+|
+| NOTE: Only SUS has a batch form, other methods select one at a time and
+|       this does nothing.  The picks are used by SE_sus() until they run
+|       out or the pool changes.
+----------------------------------------------------------------------------*/
+int SE_batch(
+   GA_Info_Ptr    ga_info,
+   Pool_Ptr       pool,
+   int            n)
+{
+   Rand_Ptr rng;
+   double   step, ptr;
+   int      i, j, tmp;
+
+   /*--- Error check ---*/
+   if(!CF_valid(ga_info)) UT_error("SE_batch: invalid ga_info");
+   if(!PL_valid(pool)) UT_error("SE_batch: invalid pool");
+
+   /*--- Nothing to draw ---*/
+   pool->num_picks = pool->next_pick = 0;
+   if(ga_info->SE_fun != SE_sus || n <= 0 || pool->size <= 0) return OK;
+
+   /*--- Make room for the picks ---*/
+   if(n > pool->max_picks) {
+      pool->pick = (int *)realloc(pool->pick, n * sizeof(int));
+      if(pool->pick == NULL) UT_error("SE_batch: pick alloc failed");
+      pool->max_picks = n;
+   }
+
+   /*--- Draws of the batch ---*/
+   rng = &ga_info->rng;
+   RN_stream(rng, ga_info->rand_seed, ga_info->iter, RN_SELECT);
+
+   /*--- Rebuild the wheel if the pool changed ---*/
+   if(pool->wheel_epoch != pool->epoch || pool->wheel_size != pool->size)
+      SE_wheel(ga_info, pool);
+
+   /*--- n equally spaced pointers, one spin ---*/
+   step = pool->wheel[pool->size-1] / n;
+   ptr  = RAND_FRAC(rng) * step;
+   for(i = 0, j = 0; i < n; i++, ptr += step) {
+      while(j < pool->size-1 && pool->wheel[j] < ptr) j++;
+      pool->pick[i] = j;
+   }
+
+   /*--- Shuffle, so parents are not neighbours on the wheel ---*/
+   for(i = n-1; i > 0; i--) {
+      j = RAND_DOM(rng, 0, i);
+      tmp = pool->pick[i]; pool->pick[i] = pool->pick[j]; pool->pick[j] = tmp;
+   }
+
+   pool->num_picks  = n;
+   pool->pick_epoch = pool->epoch;
+
+   return OK;
+}
+
 /*============================================================================
 |                             Selection Methods
 ============================================================================*/
@@ -4311,94 +7082,229 @@ SE_uniform_random(GA_Info_Ptr    ga_info,
    /*--- Error check ---*/
    if(!CF_valid(ga_info)) UT_error("SE_uniform_random: invalid ga_info");
 
-   return RAND_DOM(0, pool->size-1);
+   return RAND_DOM(&ga_info->rng, 0, pool->size-1);
 }
 
 /*----------------------------------------------------------------------------
 | Roulette
+|
+| NOTE: the wheel is only rebuilt when the pool has changed since the last
+|       spin, so a generation of selections from the same pool costs one
+|       PL_update_ptf() and a binary search per pick
 ----------------------------------------------------------------------------*/
 SE_roulette(GA_Info_Ptr    ga_info,
    Pool_Ptr       pool)
 {
    /*--- Error check ---*/
    if(!CF_valid(ga_info)) UT_error("SE_roulette: invalid ga_info");
+   if(!PL_valid(pool)) UT_error("SE_roulette: invalid pool");
+   if(pool->size <= 0) UT_error("SE_roulette: empty pool");
 
-   /*--- Find PTF for each chromosome ---*/                         
-   PL_update_ptf(ga_info, pool);
+   /*--- Rebuild the wheel if the pool changed ---*/
+   if(pool->wheel_epoch != pool->epoch || pool->wheel_size != pool->size)
+      SE_wheel(ga_info, pool);
 
-   if(ga_info->minimize)         
-      return SE_min_roulette(ga_info, pool);
-   else
-      return SE_max_roulette(ga_info, pool);
+   return SE_spin(pool, RAND_FRAC(&ga_info->rng) * pool->wheel[pool->size-1]);
 }      
 
 /*----------------------------------------------------------------------------
-| Roulette helper (maximizing)
+| Roulette helper (build the wheel)
+|
+| NOTE: slot i of the wheel holds the ptf of chroms 0..i, which is the
+|       scaled fitness share when maximizing and the inverted share when
+|       minimizing (see PL_update_ptf())
 ----------------------------------------------------------------------------*/
-SE_max_roulette(GA_Info_Ptr    ga_info,   Pool_Ptr       pool)
+int SE_wheel(GA_Info_Ptr    ga_info,
+   Pool_Ptr       pool)
 {
-   int   i = 0;
-   float val = 0.0, spin_val;
+   int    i;
+   double val = 0.0;
 
-   /*--- Error check ---*/
-   if(!CF_valid(ga_info)) UT_error("SE_max_roulette: invalid ga_info");
+   /*--- Find PTF for each chromosome ---*/
+   PL_update_ptf(ga_info, pool);
 
-   /*--- Spin the wheel ---*/
-   spin_val = RAND_FRAC() * pool->total_fitness;
+   /*--- Make room for the wheel ---*/
+   if(pool->wheel == NULL || pool->wheel_size < pool->size) {
+      pool->wheel = (double *)realloc(pool->wheel, 
+                                      pool->max_size * sizeof(double));
+      if(pool->wheel == NULL) UT_error("SE_wheel: wheel alloc failed");
+   }
 
-   /*--- Find corresponding chromosome ---*/
-   while(val < spin_val && i < pool->size)
-      val += pool->chrom[i++]->fitness;
-   if(i > 0) i--;
+   /*--- Cumulative ptf ---*/
+   for(i = 0; i < pool->size; i++) {
+      val += pool->chrom[i]->ptf;
+      pool->wheel[i] = val;
+   }
+   pool->wheel_size  = pool->size;
+   pool->wheel_epoch = pool->epoch;
 
-   return i;
+   return OK;
 }
 
 /*----------------------------------------------------------------------------
-| Roulette helper (minimizing)
+| Roulette helper (spin the wheel): first slot reaching spin_val
 ----------------------------------------------------------------------------*/
-SE_min_roulette(GA_Info_Ptr    ga_info,
-   Pool_Ptr       pool)
+int SE_spin(Pool_Ptr       pool,
+   double         spin_val)
 {
-   int   i = 0;
-   float val = 0.0, spin_val;
+   int lo = 0, hi = pool->wheel_size - 1, mid;
+
+   /*--- Binary search ---*/
+   while(lo < hi) {
+      mid = (lo + hi) / 2;
+      if(pool->wheel[mid] < spin_val)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
 
+   return lo;
+}
+
+/*----------------------------------------------------------------------------
+| Stochastic universal sampling
+|
+| NOTE: Hands out the picks drawn by SE_batch().  Without a batch for the
+|       current pool (e.g. steady state GA), a sample of one is drawn,
+|       which is a roulette spin.
+----------------------------------------------------------------------------*/
+int SE_sus(GA_Info_Ptr    ga_info,
+   Pool_Ptr       pool)
+{
    /*--- Error check ---*/
-   if(!CF_valid(ga_info)) UT_error("SE_min_roulette: invalid ga_info");
+   if(!CF_valid(ga_info)) UT_error("SE_sus: invalid ga_info");
+   if(!PL_valid(pool)) UT_error("SE_sus: invalid pool");
 
-   /*--- Spin the wheel (value between 0.0 and 100.0) ---*/
-   spin_val = RAND_FRAC() * 100.0;
+   /*--- Next pick of the batch ---*/
+   if(pool->next_pick < pool->num_picks && pool->pick_epoch == pool->epoch)
+      return pool->pick[pool->next_pick++];
 
-   /*--- Find corresponding chromosome ---*/
-   while(val < spin_val && i < pool->size)
-      val += pool->chrom[i++]->ptf;
-   if(i > 0) i--;
+   return SE_roulette(ga_info, pool);
+}
 
-   return i;
+/*----------------------------------------------------------------------------
+| Tournament: the fittest of tn_size chroms picked at random (with
+| replacement)
+|
+| NOTE: Needs neither ptf nor a sorted pool, so it costs tn_size draws per
+|       pick however often the pool changes (e.g. steady state GA)
+----------------------------------------------------------------------------*/
+int SE_tournament(GA_Info_Ptr    ga_info,
+   Pool_Ptr       pool)
+{
+   int i, idx, best;
+
+   /*--- Error check ---*/
+   if(!CF_valid(ga_info)) UT_error("SE_tournament: invalid ga_info");
+
+   best = RAND_DOM(&ga_info->rng, 0, pool->size-1);
+   for(i = 1; i < ga_info->tn_size; i++) {
+      idx = RAND_DOM(&ga_info->rng, 0, pool->size-1);
+      if(ga_info->minimize ? 
+         pool->chrom[idx]->fitness < pool->chrom[best]->fitness :
+         pool->chrom[idx]->fitness > pool->chrom[best]->fitness)
+         best = idx;
+   }
+
+   return best;
 }
 
 /*----------------------------------------------------------------------------
 | Rank biased 
+|
+| NOTE: The pool is only sorted when it changed since PL_sort() or since
+|       PL_stats() found it in order (e.g. replacement by_rank)
+|
+| NOTE: A rank is drawn from the alias table of the pool size and bias
+|       (see SE_rank_table()), a column and a coin, instead of inverting
+|       the linear bias with a sqrt() for every pick
 ----------------------------------------------------------------------------*/
 SE_rank_biased(GA_Info_Ptr    ga_info,
    Pool_Ptr       pool)
 {
-   static int ranked = FALSE;
+   int i;
 
    /*--- Error check ---*/
    if(!CF_valid(ga_info)) UT_error("SE_rank_biased: invalid ga_info");
 
-   /*--- Rank pool ---*/
-   if(!ranked) {
-      PL_sort(ga_info, pool);
+   /*--- Rank pool, unless unchanged since it was sorted ---*/
+   if(pool->sort_epoch != pool->epoch) PL_sort(ga_info, pool);
 
-      /*--- Only rank once if replacement is by_rank ---*/
-      if(!strcmp(RE_name(ga_info), "by_rank")) ranked = TRUE;
-   }
+   /*--- Table for this pool size and bias ---*/
+   if(pool->rank_size != pool->size || pool->rank_bias != ga_info->bias)
+      SE_rank_table(ga_info, pool);
 
    /*--- Linear biased selection ---*/
-   return pool->size * (ga_info->bias - sqrt(ga_info->bias * ga_info->bias
-          - 4.0 * (ga_info->bias-1) * RAND_FRAC())) / 2.0 / (ga_info->bias-1);
+   i = RAND_DOM(&ga_info->rng, 0, pool->size-1);
+   if(RAND_FRAC(&ga_info->rng) < pool->rank_prob[i]) 
+      return i;
+   else
+      return pool->rank_alias[i];
+}
+
+/*----------------------------------------------------------------------------
+| Rank biased helper (alias table)
+|
+| Rank k (best first) of n is picked with probability F((k+1)/n) - F(k/n),
+| F(t) = bias t - (bias-1) t^2, as by the inverse of F in Genitor.  The
+| table (Walker's alias method, Vose's construction) turns this into n
+| equally likely columns: column k keeps rank k with probability
+| rank_prob[k] and gives rank_alias[k] otherwise.
+----------------------------------------------------------------------------*/
+int SE_rank_table(GA_Info_Ptr    ga_info,
+   Pool_Ptr       pool)
+{
+   int    *work, n, k, num_small, num_large, small, large;
+   double bias, t0, t1;
+
+   n    = pool->size;
+   bias = ga_info->bias;
+
+   /*--- Make room for the table ---*/
+   pool->rank_prob  = (double *)realloc(pool->rank_prob, n * sizeof(double));
+   pool->rank_alias = (int *)realloc(pool->rank_alias, n * sizeof(int));
+   work = (int *)malloc(n * sizeof(int));
+   if(pool->rank_prob == NULL || pool->rank_alias == NULL || work == NULL)
+      UT_error("SE_rank_table: table alloc failed");
+
+   /*--- Probability of each rank, times n ---*/
+   for(k = 0; k < n; k++) {
+      t0 = (double)k / n;
+      t1 = (double)(k+1) / n;
+      pool->rank_prob[k]  = n * (bias * (t1 - t0) - 
+                                 (bias-1) * (t1*t1 - t0*t0));
+      pool->rank_alias[k] = k;
+   }
+
+   /*--- Small ones stacked from the front, large ones from the back ---*/
+   num_small = 0;
+   num_large = n;
+   for(k = 0; k < n; k++) {
+      if(pool->rank_prob[k] < 1.0) work[num_small++] = k;
+      else                         work[--num_large] = k;
+   }
+
+   /*--- Top up each small column with a large one ---*/
+   while(num_small > 0 && num_large < n) {
+      small = work[--num_small];
+      large = work[num_large];
+      pool->rank_alias[small] = large;
+      pool->rank_prob[large] -= 1.0 - pool->rank_prob[small];
+      if(pool->rank_prob[large] < 1.0) {
+         num_large++;
+         work[num_small++] = large;
+      }
+   }
+
+   /*--- Left overs are full columns (up to rounding) ---*/
+   while(num_small > 0) pool->rank_prob[work[--num_small]] = 1.0;
+   while(num_large < n) pool->rank_prob[work[num_large++]] = 1.0;
+   free(work);
+
+   pool->rank_size = n;
+   pool->rank_bias = ga_info->bias;
+
+   return OK;
 }
 
 
@@ -4420,5 +7326,1061 @@ void re_evaluate_pop(GA_Info_Ptr ga_info)
 		  ga_info->best=ga_info->old_pool->chrom[i];
 		}
     }
+    PL_touch(ga_info->old_pool);
     
 }
+/*============================================================================
+| (c) Copyright IA UPM - Group 5, 2020.  All rights reserved.
+|
+| Graph (max clique instance) management
+|
+| Functions:
+|    GR_alloc()    - allocate a graph
+|    GR_free()     - deallocate a graph
+|    GR_valid()    - is a graph valid?
+|    GR_add_edge() - add an edge to a graph
+|    GR_count()    - count nodes and edges selected by a chrom
+|    GR_delta()    - update GR_count() after a few loci changed
+|    GR_degree()   - number of neighbours of a node
+|    GR_greedy()   - size of a clique found greedily
+|    GR_degeneracy() - smallest-last order of the k-core of a graph
+|    GR_subgraph() - graph induced by some nodes, renumbered
+|    GR_prepare()  - reorder and prune ga_info->graph before a run
+|    GR_read()     - read a graph in DIMACS format
+|    GR_load()     - load a graph, compiling it the first time
+|    GR_map()      - map a compiled graph, read only
+|    GR_write()    - write a compiled graph
+|    UT_popcount() - number of bits set in a word
+|    UT_map_file() - map a whole file into memory, read only
+|    UT_unmap_file() - release a file mapped by UT_map_file()
+|    UT_file_stamp() - size and modification time of a file
+|    UT_checksum() - 64 bit checksum of some words
+|
+| NOTE: Adjacency rows are packed 64 nodes per word, so the edges between
+|       a node and a set of nodes are counted with a popcount per word.
+|
+| NOTE: A compiled graph (x.clq.bin for x.clq.txt) is a GR_File_Type header
+|       followed by the node degrees (ints, padded to a word) and the
+|       adjacency rows, exactly as kept in memory.  GR_load() maps it read
+|       only, so runs on the same instance share its pages, and rewrites it
+|       when it does not match the size and time of the text file.  The 
+|       checksum in the header is checked when the file is written and 
+|       whenever a compiled graph is loaded by name.
+============================================================================*/
+
+/*--- Compiled graph file header ---*/
+#define GR_FILE_MAGIC   0x0031514C43414700ULL  /* "\0GACLQ1\0" */
+#define GR_FILE_VERSION 1
+
+typedef struct {
+   Word_Type  magic;                /* GR_FILE_MAGIC */
+   int32_t    version;              /* GR_FILE_VERSION */
+   int32_t    nnodes, nedges;       /* Number of nodes and edges */
+   int32_t    nwords;               /* Words per adjacency row */
+   int64_t    src_size, src_mtime;  /* Stamp of the text file */
+   Word_Type  checksum;             /* Of degrees and adjacency rows */
+} GR_File_Type, *GR_File_Ptr;
+
+/*--- Bytes of the degrees, padded to a word ---*/
+#define GR_DEG_SIZE(n) (((size_t)(n) * sizeof(int) + sizeof(Word_Type) - 1) \
+                        / sizeof(Word_Type) * sizeof(Word_Type))
+
+/*----------------------------------------------------------------------------
+| Allocate a graph
+----------------------------------------------------------------------------*/
+Graph_Ptr GR_alloc(
+   int nnodes)
+{
+   Graph_Ptr graph;
+
+   /*--- Error check ---*/
+   if(nnodes <= 0) UT_error("GR_alloc: invalid nnodes");
+
+   /*--- Allocate memory for graph ---*/
+   graph = (Graph_Ptr)calloc(1, sizeof(Graph_Type));
+   if(graph == NULL) UT_error("GR_alloc: graph alloc failed");
+   graph->nnodes = nnodes;
+   graph->nedges = 0;
+   graph->nwords = NUM_WORDS(nnodes);
+   graph->norig  = nnodes;
+   graph->orig   = NULL;
+
+   /*--- Allocate memory for adjacency rows ---*/
+   graph->adj = (Word_Ptr)calloc((size_t)nnodes * graph->nwords, 
+                                 sizeof(Word_Type));
+   if(graph->adj == NULL) UT_error("GR_alloc: adj alloc failed");
+
+   /*--- Put in magic cookie ---*/
+   graph->magic_cookie = GR_cookie;
+
+   return graph;
+}
+
+/*----------------------------------------------------------------------------
+| De-Allocate a graph
+----------------------------------------------------------------------------*/
+int GR_free(
+   Graph_Ptr graph)
+{
+   /*--- Error check ---*/
+   if(!GR_valid(graph)) return GA_ERROR;
+
+   /*--- Free memory for adjacency rows and node map ---*/
+   if(graph->map != NULL)
+      UT_unmap_file(graph->map, graph->map_size);
+   else {
+      free(graph->adj);
+      if(graph->degree != NULL) free(graph->degree);
+   }
+   graph->adj = NULL;
+   graph->degree = NULL;
+   graph->map = NULL;
+   if(graph->orig != NULL) free(graph->orig);
+   graph->orig = NULL;
+
+   /*--- Put in NULL magic cookie ---*/
+   graph->magic_cookie = NL_cookie;
+
+   /*--- Free memory for graph ---*/
+   free(graph);
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Is a graph valid, i.e., has it been allocated by GR_alloc()?
+----------------------------------------------------------------------------*/
+int GR_valid(
+   Graph_Ptr graph)
+{
+   /*--- Check for NULL pointers ---*/
+   if(graph == NULL) return FALSE;
+   if(graph->adj == NULL) return FALSE;
+
+   /*--- Check for magic cookie ---*/
+   if(graph->magic_cookie != GR_cookie) return FALSE;
+
+   /*--- Otherwise valid ---*/
+   return TRUE;
+}
+
+/*----------------------------------------------------------------------------
+| Add edge (u,v) to a graph, nodes numbered from 0
+----------------------------------------------------------------------------*/
+int GR_add_edge(
+   Graph_Ptr graph,
+   int       u, int v)
+{
+   /*--- Error check ---*/
+   if(!GR_valid(graph)) UT_error("GR_add_edge: invalid graph");
+   if(u < 0 || u >= graph->nnodes) UT_error("GR_add_edge: invalid u");
+   if(v < 0 || v >= graph->nnodes) UT_error("GR_add_edge: invalid v");
+   if(graph->map != NULL) UT_error("GR_add_edge: graph is read only");
+
+   /*--- Ignore loops and repeated edges ---*/
+   if(u == v || BIT_TEST(GR_row(graph, u), v)) return OK;
+
+   BIT_SET(GR_row(graph, u), v);
+   BIT_SET(GR_row(graph, v), u);
+   graph->nedges++;
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Count the nodes (v) selected by a bit chrom and the edges (a) among them
+----------------------------------------------------------------------------*/
+int GR_count(
+   Graph_Ptr graph,
+   Chrom_Ptr chrom,
+   int       *v, int *a)
+{
+   Word_Type set[graph->nwords];
+   Word_Ptr  row;
+   int       i, k, len, edges;
+
+   /*--- Error check ---*/
+   if(chrom->length > graph->nnodes) UT_error("GR_count: chrom too long");
+
+   /*--- Pack selected nodes ---*/
+   memset(set, 0, sizeof(set));
+   len = chrom->length;
+   *v  = 0;
+   if(CH_packed(chrom)) {
+      for(k = 0; k < NUM_WORDS(len); k++) {
+         set[k] = chrom->bits[k];
+         *v += POPCOUNT(set[k]);
+      }
+   } else {
+      for(i = 0; i < len; i++) {
+         if(chrom->gene[i] == 1) BIT_SET(set, i);
+         *v += chrom->gene[i];
+      }
+   }
+
+   /*--- Each edge among the selected nodes is seen from both ends ---*/
+   edges = 0;
+   for(i = 0; i < len; i++) {
+      if(!BIT_TEST(set, i)) continue;
+      row = GR_row(graph, i);
+      for(k = 0; k < graph->nwords; k++)
+         edges += POPCOUNT(row[k] & set[k]);
+   }
+   *a = edges / 2;
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Update the nodes and edges selected by a chrom after a few loci changed
+|
+| NOTE: The state kept in chrom->ev_state is
+|          st[0]        = selected nodes
+|          st[1]        = edges among the selected nodes
+|          st[2+i]      = selected neighbours of node i
+|          st[2+n+i]    = is node i selected?
+|       so flipping node k costs one pass over the neighbours of k instead
+|       of a full GR_count().  Only 0/1 genes are supported.
+----------------------------------------------------------------------------*/
+int *GR_delta(
+   Graph_Ptr graph,
+   Chrom_Ptr chrom)
+{
+   int      *st, *cnt, *sel;
+   Word_Ptr row;
+   int      i, j, k, c, n, len, now;
+   Word_Type w;
+
+   /*--- Error check ---*/
+   if(chrom->length > graph->nnodes) UT_error("GR_delta: chrom too long");
+
+   n   = graph->nnodes;
+   len = chrom->length;
+   st  = CH_ev_state(chrom, 2 + 2 * n);
+   cnt = st + 2;
+   sel = st + 2 + n;
+
+   /*--- Rebuild the state from scratch ---*/
+   if(!chrom->ev_valid || chrom->num_changed < 0) {
+      GR_count(graph, chrom, &st[0], &st[1]);
+      memset(cnt, 0, 2 * n * sizeof(int));
+      for(i = 0; i < len; i++) {
+         if(CH_gene(chrom, i) != 1) continue;
+         sel[i] = TRUE;
+         row = GR_row(graph, i);
+         for(j = 0; j < graph->nwords; j++)
+            for(w = row[j]; w; w &= w - 1)
+               cnt[j * WORD_BITS + LOWBIT(w)]++;
+      }
+      return st;
+   }
+
+   /*--- Apply each changed locus ---*/
+   for(c = 0; c < chrom->num_changed; c++) {
+      k   = chrom->changed[c];
+      now = (CH_gene(chrom, k) == 1);
+      if(now == sel[k]) continue;
+      sel[k] = now;
+
+      /*--- Edges to the other selected nodes come and go with k ---*/
+      if(now) {
+         st[0]++;
+         st[1] += cnt[k];
+      } else {
+         st[0]--;
+         st[1] -= cnt[k];
+      }
+
+      row = GR_row(graph, k);
+      for(j = 0; j < graph->nwords; j++)
+         for(w = row[j]; w; w &= w - 1)
+            cnt[j * WORD_BITS + LOWBIT(w)] += now ? 1 : -1;
+   }
+
+   return st;
+}
+
+/*----------------------------------------------------------------------------
+| Number of neighbours of node i
+----------------------------------------------------------------------------*/
+int GR_degree(
+   Graph_Ptr graph,
+   int       i)
+{
+   Word_Ptr row;
+   int      k, deg;
+
+   if(graph->degree != NULL) return graph->degree[i];
+
+   row = GR_row(graph, i);
+   for(deg = k = 0; k < graph->nwords; k++) deg += POPCOUNT(row[k]);
+
+   return deg;
+}
+
+/*----------------------------------------------------------------------------
+| Size of a clique found greedily, a lower bound for the max clique
+----------------------------------------------------------------------------*/
+int GR_greedy(
+   Graph_Ptr graph)
+{
+   Word_Type set[graph->nwords];
+
+   /*--- Error check ---*/
+   if(!GR_valid(graph)) UT_error("GR_greedy: invalid graph");
+
+   memset(set, 0, sizeof(set));
+   return LS_clique_add(graph, set, graph->nnodes);
+}
+
+/*----------------------------------------------------------------------------
+| Smallest-last order of the k-core of a graph
+|
+| NOTE: Nodes are peeled off by smallest degree among the remaining nodes.
+|       While that degree is below k the node cannot be in the k-core, the
+|       largest subgraph where every node has k neighbours or more.  The
+|       k-core nodes are stored in order[] last peeled first, so the
+|       densest core comes first.  Returns the size of the k-core.
+----------------------------------------------------------------------------*/
+int GR_degeneracy(
+   Graph_Ptr graph,
+   int       k,
+   int       *order)
+{
+   int       *deg;
+   Word_Ptr  row;
+   Word_Type w;
+   int       i, j, n, min, pos, core;
+
+   /*--- Error check ---*/
+   if(!GR_valid(graph)) UT_error("GR_degeneracy: invalid graph");
+   if(order == NULL) UT_error("GR_degeneracy: NULL order");
+
+   n   = graph->nnodes;
+   deg = (int *)calloc(n, sizeof(int));
+   if(deg == NULL) UT_error("GR_degeneracy: alloc failed");
+   for(i = 0; i < n; i++) deg[i] = GR_degree(graph, i);
+
+   /*--- Peel; deg[i] < 0 marks a peeled node ---*/
+   core = -1;
+   for(pos = n - 1; pos >= 0; pos--) {
+      min = -1;
+      for(i = 0; i < n; i++)
+         if(deg[i] >= 0 && (min < 0 || deg[i] < deg[min])) min = i;
+      if(core < 0 && deg[min] >= k) core = pos + 1;
+
+      order[pos] = min;
+      deg[min] = -1;
+      row = GR_row(graph, min);
+      for(j = 0; j < graph->nwords; j++)
+         for(w = row[j]; w; w &= w - 1) {
+            i = j * WORD_BITS + LOWBIT(w);
+            if(deg[i] > 0) deg[i]--;
+         }
+   }
+
+   free(deg);
+   return core < 0 ? 0 : core;
+}
+
+/*----------------------------------------------------------------------------
+| Graph induced by nodes[0..n-1], node i of the subgraph being nodes[i]
+----------------------------------------------------------------------------*/
+Graph_Ptr GR_subgraph(
+   Graph_Ptr graph,
+   int       *nodes,
+   int       n)
+{
+   Graph_Ptr sub;
+   Word_Ptr  row;
+   int       i, j;
+
+   /*--- Error check ---*/
+   if(!GR_valid(graph)) UT_error("GR_subgraph: invalid graph");
+   if(nodes == NULL) UT_error("GR_subgraph: NULL nodes");
+
+   sub = GR_alloc(n);
+   sub->norig = graph->norig;
+   sub->orig  = (int *)calloc(n, sizeof(int));
+   if(sub->orig == NULL) UT_error("GR_subgraph: orig alloc failed");
+
+   for(i = 0; i < n; i++) {
+      sub->orig[i] = GR_orig(graph, nodes[i]);
+      row = GR_row(graph, nodes[i]);
+      for(j = 0; j < i; j++)
+         if(BIT_TEST(row, nodes[j])) GR_add_edge(sub, i, j);
+   }
+
+   return sub;
+}
+
+/*----------------------------------------------------------------------------
+| Reorder and prune ga_info->graph as configured, then size the chrom
+|
+| NOTE: ga_info->graph is replaced by a new graph when anything is changed;
+|       the caller still owns (and may reuse) the old one.
+|       A node with fewer than p-1 neighbours in the remaining graph cannot
+|       be in a clique of p nodes, so pruning the (p-1)-core still keeps
+|       every clique of p nodes or more.
+----------------------------------------------------------------------------*/
+int GR_prepare(
+   GA_Info_Ptr ga_info)
+{
+   Graph_Ptr graph;
+   int       *order, *deg;
+   int       i, j, n, p, tmp;
+
+   /*--- Error check ---*/
+   if(!CF_valid(ga_info)) UT_error("GR_prepare: invalid ga_info");
+   if(!GR_valid(ga_info->graph)) UT_error("GR_prepare: invalid graph");
+
+   graph = ga_info->graph;
+   ga_info->chrom_len = graph->nnodes;
+   if(ga_info->gr_order == GR_ORDER_NONE && ga_info->gr_prune == 0)
+      return OK;
+
+   /*--- Clique size to prune below ---*/
+   p = ga_info->gr_prune;
+   if(p == GR_PRUNE_GREEDY) p = GR_greedy(graph);
+
+   /*--- Nodes of the (p-1)-core ---*/
+   order = (int *)calloc(graph->nnodes, sizeof(int));
+   deg   = (int *)calloc(graph->nnodes, sizeof(int));
+   if(order == NULL || deg == NULL) UT_error("GR_prepare: alloc failed");
+   n = GR_degeneracy(graph, p - 1, order);
+   if(n <= 0) UT_error("GR_prepare: every node pruned");
+
+   /*--- Degeneracy order is already there, others by insertion sort ---*/
+   if(ga_info->gr_order != GR_ORDER_DEGENERACY) {
+      for(i = 0; i < n; i++) deg[order[i]] = GR_degree(graph, order[i]);
+      for(i = 1; i < n; i++) {
+         tmp = order[i];
+         for(j = i; j > 0; j--) {
+            if(ga_info->gr_order == GR_ORDER_DEGREE) {
+               if(deg[order[j-1]] > deg[tmp] ||
+                  (deg[order[j-1]] == deg[tmp] && order[j-1] < tmp)) break;
+            } else if(order[j-1] < tmp) break;
+            order[j] = order[j-1];
+         }
+         order[j] = tmp;
+      }
+   }
+
+   ga_info->graph = GR_subgraph(graph, order, n);
+   ga_info->chrom_len = n;
+   free(order);
+   free(deg);
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Read a graph in DIMACS format, nodes renumbered from 0
+|
+| NOTE: The file is mapped and scanned in place.  Only the 'p' (problem)
+|       and 'e' (edge) lines are used; comments and node lines are skipped.
+----------------------------------------------------------------------------*/
+Graph_Ptr GR_read(
+   char *filename)
+{
+   Graph_Ptr graph;
+   Word_Ptr  row_u, row_v;
+   char      *buf, *p, *end;
+   size_t    size;
+   int       u, v;
+
+   /*--- Map the file ---*/
+   buf = UT_map_file(filename, &size);
+   if(buf == NULL) {
+      fprintf(stderr, "GA_ERROR: GR_read: cannot open file %s\n", filename);
+      exit(1);
+   }
+
+   graph = NULL;
+   end = buf + size;
+   for(p = buf; p < end; p++) {
+      switch(*p) {
+         case 'p':
+            /*--- Problem line: p <format> nnodes nedges ---*/
+            if(graph != NULL) UT_error("GR_read: repeated problem line");
+            for(p++; p < end && (*p == ' ' || *p == '\t'); p++);
+            for(; p < end && *p > ' '; p++);
+            u = GR_parse_int(&p, end);
+            if(u <= 0) UT_error("GR_read: invalid problem line");
+            graph = GR_alloc(u);
+            break;
+
+         case 'e':
+            /*--- Edge line: e u v, nodes numbered from 1 ---*/
+            if(graph == NULL) UT_error("GR_read: edge before problem line");
+            p++;
+            u = GR_parse_int(&p, end) - 1;
+            v = GR_parse_int(&p, end) - 1;
+            if(u < 0 || u >= graph->nnodes || v < 0 || v >= graph->nnodes)
+               UT_error("GR_read: invalid edge line");
+
+            /*--- Same as GR_add_edge(), without the checks ---*/
+            row_u = GR_row(graph, u);
+            if(u == v || BIT_TEST(row_u, v)) break;
+            row_v = GR_row(graph, v);
+            BIT_SET(row_u, v);
+            BIT_SET(row_v, u);
+            graph->nedges++;
+            break;
+      }
+
+      /*--- Skip to the end of the line ---*/
+      p = memchr(p, '\n', end - p);
+      if(p == NULL) break;
+   }
+
+   UT_unmap_file(buf, size);
+   if(graph == NULL) UT_error("GR_read: no problem line");
+
+   return graph;
+}
+
+/*----------------------------------------------------------------------------
+| Load a graph: a compiled graph (*.bin), or a DIMACS file, through its
+| compiled graph when it is up to date
+|
+| NOTE: The first load of a DIMACS file writes its compiled graph, if the
+|       directory is writable, and checks it once against its checksum.
+|       Later loads only map it, without reading every page.  A compiled
+|       graph given by name is always checked, once per load.
+----------------------------------------------------------------------------*/
+Graph_Ptr GR_load(
+   char *filename)
+{
+   Graph_Ptr graph, check;
+   char      *binname;
+   size_t    len;
+
+   /*--- Compiled graph given, nothing vouches for it: check it all ---*/
+   len = strlen(filename);
+   if(len > 4 && !strcmp(filename + len - 4, ".bin")) {
+      graph = GR_map(filename, NULL, TRUE);
+      if(graph == NULL) {
+         fprintf(stderr, "GA_ERROR: GR_load: invalid compiled graph %s\n", 
+                 filename);
+         exit(1);
+      }
+      return graph;
+   }
+
+   /*--- x.txt is compiled to x.bin, anything else to anything.bin ---*/
+   binname = (char *)malloc(len + 5);
+   if(binname == NULL) UT_error("GR_load: alloc failed");
+   strcpy(binname, filename);
+   if(len > 4 && !strcmp(binname + len - 4, ".txt")) binname[len - 4] = '\0';
+   strcat(binname, ".bin");
+
+   /*--- Map it, or read the text and compile it for next time ---*/
+   graph = GR_map(binname, filename, FALSE);
+   if(graph == NULL) {
+      graph = GR_read(filename);
+      if(GR_write(graph, binname, filename) == OK) {
+
+         /*--- Make sure what later loads map is what was written ---*/
+         check = GR_map(binname, filename, TRUE);
+         if(check == NULL) {
+            UT_warn("GR_load: compiled graph does not check, removed");
+            remove(binname);
+         } else
+            GR_free(check);
+      }
+   }
+
+   free(binname);
+   return graph;
+}
+
+/*----------------------------------------------------------------------------
+| Map a compiled graph, read only; NULL if it is not valid or, when the
+| text file it came from is given, out of date
+|
+| NOTE: Only the header, size and stamp are checked, unless verify asks
+|       for the checksum too, which reads every page of the file.
+----------------------------------------------------------------------------*/
+Graph_Ptr GR_map(
+   char *filename,
+   char *source,
+   int  verify)
+{
+   Graph_Ptr   graph;
+   GR_File_Ptr head;
+   char        *buf;
+   size_t      size, need;
+   long        src_size, src_mtime;
+   int         valid;
+
+   buf = UT_map_file(filename, &size);
+   if(buf == NULL) return NULL;
+   head = (GR_File_Ptr)buf;
+
+   /*--- Check header, size, stamp (and checksum), cheapest first ---*/
+   valid = size >= sizeof(GR_File_Type) && head->magic == GR_FILE_MAGIC &&
+           head->version == GR_FILE_VERSION && head->nnodes > 0 &&
+           head->nwords == NUM_WORDS(head->nnodes);
+   if(valid) {
+      need = sizeof(GR_File_Type) + GR_DEG_SIZE(head->nnodes) +
+             (size_t)head->nnodes * head->nwords * sizeof(Word_Type);
+      valid = (size == need);
+   }
+   if(valid && source != NULL)
+      valid = UT_file_stamp(source, &src_size, &src_mtime) == OK &&
+              head->src_size == src_size && head->src_mtime == src_mtime;
+   if(valid && verify)
+      valid = UT_checksum(buf + sizeof(GR_File_Type), 
+                 (size - sizeof(GR_File_Type)) / sizeof(Word_Type)) == 
+              head->checksum;
+   if(!valid) {
+      UT_unmap_file(buf, size);
+      return NULL;
+   }
+
+   /*--- The graph points into the mapping ---*/
+   graph = (Graph_Ptr)calloc(1, sizeof(Graph_Type));
+   if(graph == NULL) UT_error("GR_map: graph alloc failed");
+   graph->nnodes   = head->nnodes;
+   graph->nedges   = head->nedges;
+   graph->nwords   = head->nwords;
+   graph->norig    = head->nnodes;
+   graph->orig     = NULL;
+   graph->degree   = (int *)(buf + sizeof(GR_File_Type));
+   graph->adj      = (Word_Ptr)(buf + sizeof(GR_File_Type) + 
+                                GR_DEG_SIZE(head->nnodes));
+   graph->map      = buf;
+   graph->map_size = size;
+
+   /*--- Put in magic cookie ---*/
+   graph->magic_cookie = GR_cookie;
+
+   return graph;
+}
+
+/*----------------------------------------------------------------------------
+| Write a compiled graph, stamped with the text file it came from
+|
+| NOTE: It is written to a temporary file and renamed, so processes
+|       mapping the old one are not disturbed.
+----------------------------------------------------------------------------*/
+int GR_write(
+   Graph_Ptr graph,
+   char      *filename,
+   char      *source)
+{
+   GR_File_Type head;
+   FILE         *fid;
+   char         *buf, *tmpname;
+   size_t       deg_size, adj_size;
+   long         src_size, src_mtime;
+   int          i, ok;
+
+   /*--- Error check ---*/
+   if(!GR_valid(graph)) UT_error("GR_write: invalid graph");
+
+   /*--- Degrees and rows in one buffer, for the checksum ---*/
+   deg_size = GR_DEG_SIZE(graph->nnodes);
+   adj_size = (size_t)graph->nnodes * graph->nwords * sizeof(Word_Type);
+   buf = (char *)calloc(1, deg_size + adj_size);
+   if(buf == NULL) UT_error("GR_write: alloc failed");
+   for(i = 0; i < graph->nnodes; i++) 
+      ((int *)buf)[i] = GR_degree(graph, i);
+   memcpy(buf + deg_size, graph->adj, adj_size);
+
+   /*--- Header ---*/
+   memset(&head, 0, sizeof(head));
+   head.magic    = GR_FILE_MAGIC;
+   head.version  = GR_FILE_VERSION;
+   head.nnodes   = graph->nnodes;
+   head.nedges   = graph->nedges;
+   head.nwords   = graph->nwords;
+   head.checksum = UT_checksum(buf, (deg_size + adj_size) / sizeof(Word_Type));
+   if(source != NULL && UT_file_stamp(source, &src_size, &src_mtime) == OK) {
+      head.src_size  = src_size;
+      head.src_mtime = src_mtime;
+   }
+
+   /*--- Write to a temporary file, then rename ---*/
+   tmpname = (char *)malloc(strlen(filename) + 32);
+   if(tmpname == NULL) UT_error("GR_write: alloc failed");
+#ifndef GA_NO_MMAP
+   sprintf(tmpname, "%s.%ld", filename, (long)getpid());
+#else
+   sprintf(tmpname, "%s.tmp", filename);
+#endif
+   ok = FALSE;
+   if((fid = fopen(tmpname, "wb")) != NULL) {
+      ok = fwrite(&head, sizeof(head), 1, fid) == 1 &&
+           fwrite(buf, deg_size + adj_size, 1, fid) == 1;
+      ok = (fclose(fid) == 0) && ok;
+      if(ok) ok = (rename(tmpname, filename) == 0);
+      if(!ok) remove(tmpname);
+   }
+
+   free(tmpname);
+   free(buf);
+   return ok ? OK : GA_ERROR;
+}
+
+/*----------------------------------------------------------------------------
+| Scan a non-negative integer at *p, skipping blanks; -1 if there is none
+----------------------------------------------------------------------------*/
+int GR_parse_int(
+   char **p,
+   char *end)
+{
+   char *q;
+   int  val;
+
+   for(q = *p; q < end && (*q == ' ' || *q == '\t'); q++);
+   if(q >= end || *q < '0' || *q > '9') {
+      *p = q;
+      return -1;
+   }
+
+   for(val = 0; q < end && *q >= '0' && *q <= '9'; q++)
+      val = val * 10 + (*q - '0');
+
+   *p = q;
+   return val;
+}
+
+/*----------------------------------------------------------------------------
+| Number of bits set in a word (when there is no builtin)
+----------------------------------------------------------------------------*/
+int UT_popcount(
+   Word_Type w)
+{
+   w = w - ((w >> 1) & 0x5555555555555555ULL);
+   w = (w & 0x3333333333333333ULL) + ((w >> 2) & 0x3333333333333333ULL);
+   w = (w + (w >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+   return (int)((w * 0x0101010101010101ULL) >> 56);
+}
+
+/*----------------------------------------------------------------------------
+| Map a whole file into memory, read only; NULL if it cannot be opened
+|
+| NOTE: Without mmap() (GA_NO_MMAP) the file is read into a buffer.
+----------------------------------------------------------------------------*/
+char *UT_map_file(
+   char   *filename,
+   size_t *size)
+{
+   char *buf;
+#ifndef GA_NO_MMAP
+   struct stat st;
+   int         fd;
+
+   if((fd = open(filename, O_RDONLY)) < 0) return NULL;
+   if(fstat(fd, &st) < 0 || st.st_size <= 0) {
+      close(fd);
+      return NULL;
+   }
+   *size = (size_t)st.st_size;
+   buf = (char *)mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+   close(fd);
+   if(buf == (char *)MAP_FAILED) return NULL;
+#ifdef MADV_SEQUENTIAL
+   madvise(buf, *size, MADV_SEQUENTIAL);
+#endif
+#else
+   FILE *fid;
+   long len;
+
+   if((fid = fopen(filename, "rb")) == NULL) return NULL;
+   fseek(fid, 0, SEEK_END);
+   len = ftell(fid);
+   fseek(fid, 0, SEEK_SET);
+   if(len <= 0 || (buf = (char *)malloc(len)) == NULL) {
+      fclose(fid);
+      return NULL;
+   }
+   *size = fread(buf, 1, len, fid);
+   fclose(fid);
+#endif
+
+   return buf;
+}
+
+/*----------------------------------------------------------------------------
+| Size and modification time of a file
+|
+| NOTE: Without stat() (GA_NO_MMAP) the time is always 0.
+----------------------------------------------------------------------------*/
+int UT_file_stamp(
+   char *filename,
+   long *size,
+   long *mtime)
+{
+#ifndef GA_NO_MMAP
+   struct stat st;
+
+   if(stat(filename, &st) < 0) return GA_ERROR;
+   *size  = (long)st.st_size;
+   *mtime = (long)st.st_mtime;
+#else
+   FILE *fid;
+
+   if((fid = fopen(filename, "rb")) == NULL) return GA_ERROR;
+   fseek(fid, 0, SEEK_END);
+   *size  = ftell(fid);
+   *mtime = 0;
+   fclose(fid);
+#endif
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| 64 bit checksum of nwords words, mixed as in CH_hash()
+----------------------------------------------------------------------------*/
+Word_Type UT_checksum(
+   void   *buf,
+   size_t nwords)
+{
+   Word_Type h, *w;
+   size_t    i;
+
+   w = (Word_Type *)buf;
+   h = (Word_Type)nwords * 0x9E3779B97F4A7C15ULL;
+   for(i = 0; i < nwords; i++) {
+      h ^= w[i];
+      h += 0x9E3779B97F4A7C15ULL;
+      h = (h ^ (h >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      h = (h ^ (h >> 27)) * 0x94D049BB133111EBULL;
+      h ^= h >> 31;
+   }
+
+   return h;
+}
+
+/*----------------------------------------------------------------------------
+| Release a file mapped by UT_map_file()
+----------------------------------------------------------------------------*/
+int UT_unmap_file(
+   char   *buf,
+   size_t size)
+{
+   if(buf == NULL) return GA_ERROR;
+#ifndef GA_NO_MMAP
+   munmap(buf, size);
+#else
+   free(buf);
+#endif
+
+   return OK;
+}
+
+/*============================================================================
+| (c) Copyright IA UPM - Group 5, 2020.  All rights reserved.
+|
+| Random number generator
+|
+| Functions:
+|    RN_seed()     - seed a generator
+|    RN_stream()   - position a generator on the stream of a trial
+|    RN_bits()     - a block of random words
+|    RN_fracs()    - a block of random numbers in [0..1)
+|    RN_philox()   - Philox4x32-10 counter based block
+|    RN_next()     - next random word (ga.h)
+|    RN_range()    - random integer in [0..n-1] (ga.h)
+|
+| NOTE: Each GA has its own generator (ga_info->rng), seeded from rand_seed
+|       by GA_run(), so runs do not share the state of the C library rand().
+|       It is xoshiro256** (Blackman and Vigna), 256 bits of state, and
+|       integer draws use a multiply and shift instead of floating point.
+|
+| NOTE: The draws of a run do not depend on the order things happen in.
+|       GA_trial(), GA_batch(), GA_gap() and PL_rand() start every trial
+|       from RN_stream(), whose state is the Philox block of the counter
+|       (trial, iter) under the key rand_seed.  Trials can then be run in
+|       any order, or on any number of threads, with the same result.
+|
+| NOTE: Operators drawing a bit per gene ask RN_bits() for whole words.
+|       Blocks of RN_BULK_MIN words or more are drawn from RN_LANES
+|       generators seeded from the first, one word of each in turn, with
+|       AVX2 when compiled for it (-mavx2).  The words are the same with
+|       or without AVX2.
+============================================================================*/
+
+/*--- Bulk generation ---*/
+#define RN_LANES     4    /* Generators side by side */
+#define RN_BULK_MIN  16   /* Smallest block worth seeding them for */
+
+/*----------------------------------------------------------------------------
+| Seed a generator, the state is filled by splitmix64 so that it is never
+| all zero and nearby seeds give unrelated streams
+----------------------------------------------------------------------------*/
+int RN_seed(
+   Rand_Ptr      rng,
+   unsigned long seed)
+{
+   Word_Type z;
+   int       i;
+
+   /*--- Error check ---*/
+   if(rng == NULL) UT_error("RN_seed: NULL generator");
+
+   z = (Word_Type)seed;
+   for(i = 0; i < 4; i++) {
+      z += 0x9E3779B97F4A7C15ULL;
+      rng->s[i] = z;
+      rng->s[i] = (rng->s[i] ^ (rng->s[i] >> 30)) * 0xBF58476D1CE4E5B9ULL;
+      rng->s[i] = (rng->s[i] ^ (rng->s[i] >> 27)) * 0x94D049BB133111EBULL;
+      rng->s[i] ^= rng->s[i] >> 31;
+   }
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Position a generator on the stream of trial number trial of iteration
+| iter (RN_INIT for the initial pool, RN_GAP for the generation gap)
+----------------------------------------------------------------------------*/
+int RN_stream(
+   Rand_Ptr rng,
+   int      seed, int iter, int trial)
+{
+   uint32_t ctr[4], key[2], out[4];
+   int      i;
+
+   /*--- Error check ---*/
+   if(rng == NULL) UT_error("RN_stream: NULL generator");
+
+   key[0] = (uint32_t)seed;
+   key[1] = 0;
+   ctr[0] = (uint32_t)trial;
+   ctr[1] = (uint32_t)iter;
+   ctr[3] = 0;
+
+   /*--- Two blocks fill the 256 bits of state ---*/
+   for(i = 0; i < 2; i++) {
+      ctr[2] = i;
+      RN_philox(ctr, key, out);
+      rng->s[2*i]   = (Word_Type)out[0] << 32 | out[1];
+      rng->s[2*i+1] = (Word_Type)out[2] << 32 | out[3];
+   }
+   if(!(rng->s[0] | rng->s[1] | rng->s[2] | rng->s[3])) rng->s[0] = 1;
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2,
+| 3"): 10 rounds of multiplies and key additions turn a counter into 128
+| random bits
+----------------------------------------------------------------------------*/
+int RN_philox(
+   uint32_t ctr[4],
+   uint32_t key[2],
+   uint32_t out[4])
+{
+   uint32_t c0, c1, c2, c3, k0, k1;
+   uint64_t p0, p1;
+   int      r;
+
+   c0 = ctr[0]; c1 = ctr[1]; c2 = ctr[2]; c3 = ctr[3];
+   k0 = key[0]; k1 = key[1];
+   for(r = 0; r < 10; r++) {
+      p0 = (uint64_t)0xD2511F53 * c0;
+      p1 = (uint64_t)0xCD9E8D57 * c2;
+      c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+      c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+      c1 = (uint32_t)p1;
+      c3 = (uint32_t)p0;
+      k0 += 0x9E3779B9;
+      k1 += 0xBB67AE85;
+   }
+   out[0] = c0; out[1] = c1; out[2] = c2; out[3] = c3;
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Fill out[0..n-1] with random words
+----------------------------------------------------------------------------*/
+int RN_bits(
+   Rand_Ptr  rng,
+   Word_Ptr  out,
+   int       n)
+{
+   Rand_Type lane[RN_LANES];
+   int       i, l;
+
+   /*--- Small blocks straight from the generator ---*/
+   if(n < RN_BULK_MIN) {
+      for(i = 0; i < n; i++) out[i] = RN_next(rng);
+      return OK;
+   }
+
+   for(l = 0; l < RN_LANES; l++) RN_seed(&lane[l], RN_next(rng));
+   i = 0;
+
+#ifdef __AVX2__
+   {
+   __m256i s0, s1, s2, s3, x, r, t;
+   Word_Type st[4][RN_LANES];
+   int       j;
+
+   /*--- State word j of every lane in one register ---*/
+   for(j = 0; j < 4; j++)
+      for(l = 0; l < RN_LANES; l++) st[j][l] = lane[l].s[j];
+   s0 = _mm256_loadu_si256((__m256i *)st[0]);
+   s1 = _mm256_loadu_si256((__m256i *)st[1]);
+   s2 = _mm256_loadu_si256((__m256i *)st[2]);
+   s3 = _mm256_loadu_si256((__m256i *)st[3]);
+
+   /*--- RN_next() on all lanes; x*5 and x*9 by shift and add ---*/
+   for( ; i + RN_LANES <= n; i += RN_LANES) {
+      x = _mm256_add_epi64(_mm256_slli_epi64(s1, 2), s1);
+      r = _mm256_or_si256(_mm256_slli_epi64(x, 7), _mm256_srli_epi64(x, 57));
+      r = _mm256_add_epi64(_mm256_slli_epi64(r, 3), r);
+      _mm256_storeu_si256((__m256i *)(out + i), r);
+
+      t  = _mm256_slli_epi64(s1, 17);
+      s2 = _mm256_xor_si256(s2, s0);
+      s3 = _mm256_xor_si256(s3, s1);
+      s1 = _mm256_xor_si256(s1, s2);
+      s0 = _mm256_xor_si256(s0, s3);
+      s2 = _mm256_xor_si256(s2, t);
+      s3 = _mm256_or_si256(_mm256_slli_epi64(s3, 45), 
+                           _mm256_srli_epi64(s3, 19));
+   }
+
+   _mm256_storeu_si256((__m256i *)st[0], s0);
+   _mm256_storeu_si256((__m256i *)st[1], s1);
+   _mm256_storeu_si256((__m256i *)st[2], s2);
+   _mm256_storeu_si256((__m256i *)st[3], s3);
+   for(j = 0; j < 4; j++)
+      for(l = 0; l < RN_LANES; l++) lane[l].s[j] = st[j][l];
+   }
+#endif
+
+   /*--- Lanes in turn (and the last few words with AVX2) ---*/
+   for( ; i < n; i++) out[i] = RN_next(&lane[i % RN_LANES]);
+
+   return OK;
+}
+
+/*----------------------------------------------------------------------------
+| Fill out[0..n-1] with random numbers in [0..1), as RAND_FRAC()
+----------------------------------------------------------------------------*/
+int RN_fracs(
+   Rand_Ptr rng,
+   double   *out,
+   int      n)
+{
+   Word_Type w;
+   int       i;
+
+   /*--- Random words in place, then scaled to 53 bit fractions ---*/
+   RN_bits(rng, (Word_Ptr)out, n);
+   for(i = 0; i < n; i++) {
+      memcpy(&w, &out[i], sizeof(w));
+      out[i] = (double)(w >> 11) * (1.0/9007199254740992.0);
+   }
+
+   return OK;
+}